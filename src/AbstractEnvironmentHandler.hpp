@@ -1,19 +1,261 @@
 #pragma once
 
+#include <chrono>
+#include <map>
+
+#include <Configuration.hpp>
+#include <Task.hpp>
 #include <Telemetry.hpp>
 
+#include "ProfiledTask.hpp"
+#include "RunningAggregate.hpp"
+#include "SensorHealth.hpp"
+#include "TelemetrySnapshotProvider.hpp"
+#include "Tracer.hpp"
+
+using namespace std::chrono;
 using namespace farmhub::client;
 
-class AbstractEnvironmentHandler : public TelemetryProvider {
-protected:
+/**
+ * @brief The size of the document caching a handler's last reading.
+ */
+const size_t ENVIRONMENT_CACHE_CAPACITY = 256;
+
+/**
+ * @brief A sensor is taken offline after this many consecutive failed samples.
+ */
+const int SENSOR_FAILURES_BEFORE_OFFLINE = 3;
+
+const milliseconds SENSOR_INITIAL_BACKOFF = seconds { 30 };
+const milliseconds SENSOR_MAX_BACKOFF = hours { 1 };
+
+/**
+ * @brief Samples an environment sensor in the background, and reports aggregates of the samples.
+ *
+ * Sampling is split in two phases: {@link #startSampling} kicks off a conversion on the sensor,
+ * and {@link #collectSample} reads the result once the conversion is done.
+ * The task sleeps in between, so slow conversions never block other tasks.
+ *
+ * Samples are taken at the configured interval, independently of how often telemetry is published,
+ * and are folded into running aggregates. {@link #populateTelemetry} reports the mean of the samples
+ * taken since the previous call under the usual keys, along with their minimum, maximum and count
+ * under <code>aggregates</code>; if there were no samples, it reports the last reading.
+ * It never touches the bus. {@link #populateSnapshot} reports the same without resetting the aggregates.
+ *
+ * Sensors that keep failing are taken offline, and are only re-initialized and sampled again after an exponential
+ * backoff, so a dead sensor costs next to nothing, while one that has been replaced or has recovered is picked up
+ * again without a restart. The health of each sensor is reported under <code>sensorHealth</code>.
+ * Handlers whose sensors have channels that fail independently track and report those via {@link #populateChannelHealth}.
+ */
+class AbstractEnvironmentHandler
+    : public TelemetryProvider,
+      public TelemetrySnapshotProvider,
+      public ProfiledTask {
+public:
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent, const String& name)
+            : NamedConfigurationSection(parent, name) {
+        }
+
+        Property<seconds> samplingInterval { this, "samplingInterval", seconds { 10 } };
+    };
+
+    AbstractEnvironmentHandler(TaskContainer& tasks, const String& name, const Config& config)
+        : ProfiledTask(tasks, name)
+        , name(name)
+        , config(config) {
+    }
+
     void populateTelemetry(JsonObject& json) override {
         if (!enabled) {
             return;
         }
-        populateTelemetryInternal(json);
+        TRACE_SCOPE("sensor/telemetry");
+        populateHealth(json);
+        populateAggregates(json, true);
+    }
+
+    void populateSnapshot(JsonObject& json) override {
+        if (!enabled) {
+            return;
+        }
+        populateAggregates(json, false);
+    }
+
+    /**
+     * @brief Samples the sensor, waiting for the conversion; for use before tasks are running.
+     */
+    void sampleNow(JsonObject& json) {
+        if (!enabled || !initialized) {
+            return;
+        }
+        delay(duration_cast<milliseconds>(startSampling()).count());
+        collectSample(json);
+    }
+
+protected:
+    const Schedule loop(const Timing& timing) override {
+        PROFILE_LOOP();
+        if (!enabled) {
+            return profiledSleepIndefinitely();
+        }
+        if (!sampling) {
+            auto now = boot_clock::now();
+            if (!health.isAttemptDue(now)) {
+                return profiledSleepFor(health.getNextAttempt() - now);
+            }
+            if (health.needsReinit()) {
+                Serial.printf("Re-initializing %s sensor\n", name.c_str());
+                health.recordReinit();
+                initialized = initialize();
+                if (!initialized) {
+                    health.recordFailure(now);
+                    return profiledSleepFor(health.getNextAttempt() - now);
+                }
+            }
+            sampling = true;
+            TRACE_SCOPE("sensor/start");
+            conversionTime = startSampling();
+            return profiledSleepFor(conversionTime);
+        }
+        sampling = false;
+        cache.clear();
+        JsonObject json = cache.to<JsonObject>();
+        TRACE_BEGIN("sensor/collect");
+        bool success = collectSample(json);
+        TRACE_END("sensor/collect");
+        if (success) {
+            health.recordSuccess();
+        } else {
+            health.recordFailure(boot_clock::now());
+            if (health.needsReinit()) {
+                Serial.printf("%s sensor is offline, retrying in %ld seconds\n",
+                    name.c_str(), (long) duration_cast<seconds>(health.getBackoff()).count());
+            }
+        }
+        for (JsonPair pair : json) {
+            aggregates[pair.key().c_str()].add(pair.value().as<double>());
+        }
+        // Keep the sampling interval regardless of how long the conversion took
+        microseconds interval = config.samplingInterval.get();
+        return profiledSleepFor(std::max(interval - conversionTime, microseconds::zero()));
+    }
+
+    /**
+     * @brief Sets up the sensor itself; called again to re-initialize it after it went offline.
+     *
+     * @return false if the sensor could not be found.
+     */
+    virtual bool initialize() = 0;
+
+    /**
+     * @brief Initializes the sensor and starts sampling; to be called once the handler is set up.
+     */
+    void beginSampling() {
+        enabled = true;
+        initialized = initialize();
+        if (!initialized) {
+            Serial.printf("%s sensor not found, retrying in %ld seconds\n",
+                name.c_str(), (long) duration_cast<seconds>(SENSOR_INITIAL_BACKOFF).count());
+            health.markOffline(boot_clock::now());
+        }
     }
 
-    virtual void populateTelemetryInternal(JsonObject& json);
+    /**
+     * @brief Starts sampling a sensor that is already initialized, e.g. before deep sleep.
+     */
+    void resumeSampling() {
+        enabled = true;
+        initialized = true;
+    }
+
+    /**
+     * @brief Starts a conversion on the sensor.
+     *
+     * @return how long until the result can be collected.
+     */
+    virtual microseconds startSampling() = 0;
+
+    /**
+     * @brief Collects the result of the conversion.
+     *
+     * @return false if the sensor failed; the JSON may still contain the values that could be read.
+     */
+    virtual bool collectSample(JsonObject& json) = 0;
 
+    /**
+     * @brief Reports the health of channels tracked separately from the sensor as a whole.
+     */
+    virtual void populateChannelHealth(JsonObject& healthsJson) {
+    }
+
+    static void populateHealth(JsonObject& healthsJson, const String& name, const SensorHealth<boot_clock>& health) {
+        JsonObject healthJson = healthsJson.createNestedObject(name);
+        healthJson["state"] = static_cast<int>(health.getState());
+        healthJson["failures"] = health.getFailureCount();
+        healthJson["consecutiveFailures"] = health.getConsecutiveFailures();
+        healthJson["reinits"] = health.getReinitCount();
+    }
+
+private:
+    /**
+     * @brief Reports the aggregates of the samples taken since they were last reset.
+     */
+    void populateAggregates(JsonObject& json, bool reset) {
+        JsonObject aggregatesJson;
+        // Values missing from the last reading may still have samples from earlier in the window
+        for (auto& entry : aggregates) {
+            const String& key = entry.first;
+            auto& aggregate = entry.second;
+            if (aggregate.getCount() == 0) {
+                if (cache.containsKey(key.c_str())) {
+                    json[key] = cache[key.c_str()].as<JsonVariantConst>();
+                }
+                continue;
+            }
+            json[key] = aggregate.getMean();
+            if (aggregatesJson.isNull()) {
+                // Other handlers may have already added their aggregates
+                aggregatesJson = json.containsKey("aggregates")
+                    ? json["aggregates"].as<JsonObject>()
+                    : json.createNestedObject("aggregates");
+            }
+            JsonObject aggregateJson = aggregatesJson.createNestedObject(key);
+            aggregateJson["min"] = aggregate.getMin();
+            aggregateJson["max"] = aggregate.getMax();
+            aggregateJson["mean"] = aggregate.getMean();
+            aggregateJson["count"] = aggregate.getCount();
+            if (reset) {
+                aggregate.reset();
+            }
+        }
+    }
+
+    void populateHealth(JsonObject& json) {
+        JsonObject healthsJson = json.containsKey("sensorHealth")
+            ? json["sensorHealth"].as<JsonObject>()
+            : json.createNestedObject("sensorHealth");
+        populateHealth(healthsJson, name, health);
+        populateChannelHealth(healthsJson);
+    }
+
+    const String name;
+    const Config& config;
     bool enabled = false;
+    bool initialized = false;
+    SensorHealth<boot_clock> health { SENSOR_FAILURES_BEFORE_OFFLINE, SENSOR_INITIAL_BACKOFF, SENSOR_MAX_BACKOFF };
+    bool sampling = false;
+    microseconds conversionTime;
+
+    /**
+     * @brief The last reading.
+     */
+    DynamicJsonDocument cache { ENVIRONMENT_CACHE_CAPACITY };
+
+    /**
+     * @brief The aggregates of each value since the last time telemetry was populated.
+     */
+    std::map<String, RunningAggregate> aggregates;
 };
@@ -6,7 +6,14 @@
 #include <Ntp.hpp>
 #include <wifi/WiFiManagerProvider.hpp>
 
+#include "AbstractEnvironmentHandler.hpp"
+#include "HeapDiagnosticsProvider.hpp"
 #include "MeterHandler.hpp"
+#include "ProfiledTask.hpp"
+#include "SampleBatchHandler.hpp"
+#include "TelemetryJournalHandler.hpp"
+#include "TelemetryTimingHandler.hpp"
+#include "Tracer.hpp"
 #include "ValveHandler.hpp"
 #include "version.h"
 
@@ -39,8 +46,52 @@ public:
     }
 
     MeterHandler::Config meter { this };
+    ValveHandler::Config actuation { this };
+    TelemetryJournalHandler::Config journal { this };
+    SampleBatchHandler::Config batching { this };
+    TelemetryTimingHandler::Config telemetryTiming { this };
+
+    /**
+     * @brief Sampling of the air temperature and humidity sensor.
+     */
+    AbstractEnvironmentHandler::Config environment { this, "environment" };
+
+    /**
+     * @brief Sampling of the soil temperature and moisture sensor, on boards that have one.
+     */
+    AbstractEnvironmentHandler::Config soil { this, "soil" };
     Property<seconds> sleepPeriod { this, "sleepPeriod", seconds::zero() };
     RawJsonEntry schedule { this, "schedule" };
+
+    /**
+     * @brief Per-zone configuration for boards with multiple valves, e.g. <code>[ { "schedule": [ ... ], "flowRate": 12.5 } ]</code>.
+     *
+     * When present, it takes precedence over the top-level <code>schedule</code>.
+     * The optional flow rate is the zone's nominal flow in liters / min, used to plan zone programs.
+     */
+    RawJsonEntry zones { this, "zones" };
+
+    /**
+     * @brief Zone programs, e.g. <code>[ { "start": "...", "period": 86400, "steps": [ { "zone": 0, "duration": 600 }, { "zone": 1, "volume": 50 } ] } ]</code>.
+     */
+    RawJsonEntry programs { this, "programs" };
+
+    /**
+     * @brief Recurring windows during which zone programs may run, in the same format as <code>schedule</code>.
+     */
+    RawJsonEntry programWindows { this, "programWindows" };
+
+    /**
+     * @brief The maximum number of zones the supply line can feed at the same time, 0 means unlimited.
+     * Applies to zone programs only; per-zone schedules and overrides are not counted.
+     */
+    Property<int> maxConcurrentZones { this, "maxConcurrentZones", 0 };
+
+    /**
+     * @brief The maximum flow of the supply line in liters / min, 0 means unlimited.
+     * Applies to zone programs only; per-zone schedules and overrides are not counted.
+     */
+    Property<double> maxFlow { this, "maxFlow", 0.0 };
 };
 
 class LedHandler : public BaseSleepListener {
@@ -87,14 +138,65 @@ class AbstractFlowControlApp
     : public Application {
 public:
     AbstractFlowControlApp(
-        AbstractFlowControlDeviceConfig& deviceConfig, ValveController& valveController)
+        AbstractFlowControlDeviceConfig& deviceConfig, const std::vector<ValveController*>& valveControllers)
         : Application("Flow control", VERSION, deviceConfig, config, wifiProvider)
         , deviceConfig(deviceConfig)
-        , valve(tasks, mqtt, events, valveController) {
-        telemetryPublisher.registerProvider(flowMeter);
-        telemetryPublisher.registerProvider(valve);
+        , valve(tasks, mqtt, events, config.actuation, flowMeter, valveControllers) {
+        registerTelemetryProvider("meter", flowMeter);
+        registerTelemetryProvider("valve", valve);
+        registerTelemetryProvider("heap", heapDiagnostics);
+        journal.registerProvider(flowMeter);
+        journal.registerProvider(valve);
+#ifdef PROFILE_TASKS
+        telemetryPublisher.registerProvider(taskDiagnostics);
+#endif
+#ifdef TRACE
+        mqtt.registerCommand("trace", [](const JsonObject& request, JsonObject& response) {
+            if (request["serial"] | false) {
+                Tracer::dump(Serial);
+            } else {
+                size_t offset = request["offset"] | 0;
+                size_t limit = std::min<size_t>(request["limit"] | TRACE_RESPONSE_LIMIT, TRACE_RESPONSE_LIMIT);
+                Tracer::populate(response, offset, limit);
+            }
+            if (request["clear"] | false) {
+                Tracer::clear();
+            }
+        });
+#endif
         config.onUpdate([&]() {
-            valve.setSchedule(config.schedule.get());
+            JsonArray zonesJson = config.zones.get();
+            std::vector<double> zoneFlowRates;
+            if (zonesJson.isNull() || zonesJson.size() == 0) {
+                valve.setSchedule(0, config.schedule.get());
+            } else {
+                for (size_t index = 0; index < zonesJson.size(); index++) {
+                    valve.setSchedule(index, zonesJson[index]["schedule"].as<JsonArray>());
+                    zoneFlowRates.push_back(zonesJson[index]["flowRate"] | 0.0);
+                }
+            }
+            valve.setHydraulicLimits(config.maxConcurrentZones.get(), config.maxFlow.get(), zoneFlowRates);
+            valve.setPrograms(config.programs.get(), config.programWindows.get());
+        });
+    }
+
+    /**
+     * @brief On a short timer wake between uploads, buffers a sample and goes back to sleep without starting the application.
+     *
+     * Must be called before {@link Application#begin}; returns if the application should start.
+     */
+    void sampleBetweenUploads() {
+        SampleBatchHandler::sampleBetweenUploads([this](JsonObject& json, uint32_t sensorConfig) {
+            sampleSensors(json, sensorConfig);
+            size_t zoneCount = valve.getZoneCount();
+            if (zoneCount == 1) {
+                json["valve"] = valveHandlerStoredState[0];
+            } else {
+                JsonArray zonesJson = json.createNestedArray("zones");
+                for (size_t zone = 0; zone < zoneCount; zone++) {
+                    zonesJson.createNestedObject()["valve"] = valveHandlerStoredState[zone];
+                }
+            }
         });
     }
 
@@ -108,25 +210,68 @@ protected:
         beginPeripherials();
 
         valve.begin();
+        journal.begin();
+
+        // We are running on the main loop's task
+        heapDiagnostics.watchTask("loop", xTaskGetCurrentTaskHandle());
+        heapDiagnostics.watchTask("valve", valve.getActuationTask());
     }
 
     virtual void beginPeripherials() = 0;
 
+    /**
+     * @brief Registers the provider with the telemetry publisher, timing its calls under the given name.
+     */
+    void registerTelemetryProvider(const char* name, TelemetryProvider& provider) {
+        telemetryPublisher.registerProvider(telemetryTiming.wrap(name, provider));
+    }
+
+    /**
+     * @brief Samples the board's sensors before the application has started, with the given sensor configuration.
+     */
+    virtual void sampleSensors(JsonObject& json, uint32_t sensorConfig) = 0;
+
+    /**
+     * @brief Board-specific sensor configuration to remember for short wakes, when the device configuration is not loaded.
+     */
+    virtual uint32_t getSensorConfig() {
+        return 0;
+    }
+
 private:
     void onSleep() {
-        if (config.sleepPeriod.get() > seconds::zero()) {
-            sleep.deepSleepFor(config.sleepPeriod.get());
+        microseconds sleepPeriod = config.sleepPeriod.get();
+        if (sleepPeriod > microseconds::zero()) {
+            // Wake up when a valve needs to change, e.g. when an override ends, so that the schedule takes over in time
+            auto nextValveChange = valve.getNextChange();
+            auto untilValveChange = duration_cast<microseconds>(nextValveChange - system_clock::now());
+            if (untilValveChange < sleepPeriod) {
+                Serial.printf("Shortening sleep to %ld seconds for valve change\n",
+                    (long) duration_cast<seconds>(untilValveChange).count());
+                sleepPeriod = untilValveChange;
+            }
+            batcher.prepareSleep(config.sleepPeriod.get(), nextValveChange,
+                deviceConfig.getFlowMeterPin(), deviceConfig.getFlowMeterQFactor(), getSensorConfig());
+            sleep.deepSleepFor(sleepPeriod);
         }
     }
 
     AbstractFlowControlDeviceConfig& deviceConfig;
-    FlowControlAppConfig config;
 
+    // These only keep a reference to their configuration section, so they can be constructed before it
     NtpHandler ntp { tasks, mdns };
     MeterHandler flowMeter { tasks, sleep, config.meter, std::bind(&AbstractFlowControlApp::onSleep, this) };
+    TelemetryTimingHandler telemetryTiming { tasks, events, config.telemetryTiming };
+    HeapDiagnosticsProvider heapDiagnostics;
 
 protected:
+    FlowControlAppConfig config;
     BlockingWiFiManagerProvider wifiProvider;
     LedHandler led { sleep };
     ValveHandler valve;
+    TelemetryJournalHandler journal { tasks, mqtt, config.journal };
+    SampleBatchHandler batcher { tasks, events, config.batching };
+#ifdef PROFILE_TASKS
+    TaskDiagnosticsProvider taskDiagnostics;
+#endif
 };
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using std::chrono::milliseconds;
+
+/**
+ * @brief Plans the peak-drive phases of valve actuations under a concurrency and current budget.
+ *
+ * Valves draw their peak (inrush) current only while switching; hold phases are cheap and
+ * are allowed to overlap freely. The scheduler staggers peak phases so that at no point more
+ * than the configured number of peaks run concurrently, or their summed current exceeds the limit.
+ *
+ * All times are offsets relative to the start of the transition.
+ */
+class ActuationScheduler {
+public:
+    struct Request {
+        size_t zone;
+        milliseconds peakDuration;
+        /**
+         * @brief Peak current in mA.
+         */
+        uint32_t peakCurrent;
+    };
+
+    struct Slot {
+        size_t zone;
+        milliseconds start;
+        milliseconds end;
+        uint32_t current;
+    };
+
+    /**
+     * @param maxConcurrent the maximum number of concurrent peak phases, 0 means unlimited.
+     * @param maxCurrent the maximum summed peak current in mA, 0 means unlimited.
+     */
+    ActuationScheduler(size_t maxConcurrent, uint32_t maxCurrent)
+        : maxConcurrent(maxConcurrent)
+        , maxCurrent(maxCurrent) {
+    }
+
+    /**
+     * @brief Finds the earliest start for the request not before <code>notBefore</code> that
+     * fits the budget next to the already planned slots, and appends the new slot.
+     *
+     * A request that exceeds the current budget on its own is planned to run alone.
+     */
+    Slot plan(std::vector<Slot>& slots, const Request& request, milliseconds notBefore = milliseconds::zero()) const {
+        milliseconds start = notBefore;
+        if (request.peakDuration > milliseconds::zero() && !fits(slots, request, start)) {
+            bool found = false;
+            for (auto& candidate : slots) {
+                if (candidate.end > notBefore
+                    && (!found || candidate.end < start)
+                    && fits(slots, request, candidate.end)) {
+                    start = candidate.end;
+                    found = true;
+                }
+            }
+        }
+        Slot slot { request.zone, start, start + request.peakDuration, request.peakCurrent };
+        slots.push_back(slot);
+        return slot;
+    }
+
+    /**
+     * @brief The time it takes to complete all planned peak phases.
+     */
+    static milliseconds getMakespan(const std::vector<Slot>& slots) {
+        milliseconds makespan = milliseconds::zero();
+        for (auto& slot : slots) {
+            if (slot.end > makespan) {
+                makespan = slot.end;
+            }
+        }
+        return makespan;
+    }
+
+private:
+    bool fits(const std::vector<Slot>& slots, const Request& request, milliseconds start) const {
+        milliseconds end = start + request.peakDuration;
+        // The load only increases at the start of a slot, so it's enough to check those points
+        if (!fitsAt(slots, request, start)) {
+            return false;
+        }
+        for (auto& slot : slots) {
+            if (slot.start > start && slot.start < end && !fitsAt(slots, request, slot.start)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool fitsAt(const std::vector<Slot>& slots, const Request& request, milliseconds time) const {
+        size_t concurrent = 0;
+        uint32_t current = 0;
+        for (auto& slot : slots) {
+            if (slot.start <= time && time < slot.end) {
+                concurrent++;
+                current += slot.current;
+            }
+        }
+        if (maxConcurrent > 0 && concurrent + 1 > maxConcurrent) {
+            return false;
+        }
+        if (maxCurrent > 0 && concurrent > 0 && current + request.peakCurrent > maxCurrent) {
+            return false;
+        }
+        return true;
+    }
+
+    const size_t maxConcurrent;
+    const uint32_t maxCurrent;
+};
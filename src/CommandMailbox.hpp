@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief A bounded, lock-free single-producer / single-consumer queue.
+ *
+ * One task may {@link #post} while another task concurrently {@link #take}s;
+ * neither ever blocks. One slot is kept free to tell a full mailbox from an empty one,
+ * so at most <code>Capacity - 1</code> commands can be waiting at any time.
+ */
+template <typename T, size_t Capacity>
+class CommandMailbox {
+    static_assert(Capacity >= 2, "Capacity must be at least 2");
+
+public:
+    /**
+     * @brief Posts a command; must only be called from the producer task.
+     *
+     * @return false if the mailbox is full and the command was dropped.
+     */
+    bool post(const T& command) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        size_t nextTail = increment(currentTail);
+        if (nextTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots[currentTail] = command;
+        tail.store(nextTail, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes the oldest command; must only be called from the consumer task.
+     *
+     * @return false if the mailbox is empty.
+     */
+    bool take(T& command) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        command = slots[currentHead];
+        head.store(increment(currentHead), std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t increment(size_t index) {
+        return index + 1 == Capacity ? 0 : index + 1;
+    }
+
+    T slots[Capacity];
+    std::atomic<size_t> head { 0 };
+    std::atomic<size_t> tail { 0 };
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+using std::chrono::microseconds;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+/**
+ * @brief The longest correlation ID kept, e.g. a UUID; longer IDs are truncated.
+ */
+const size_t COMMAND_CORRELATION_ID_LENGTH = 36;
+
+/**
+ * @brief Timestamps of a remote command on its way to the valve, for measuring end-to-end command latency.
+ *
+ * Device timestamps are in microseconds since the epoch, 0 meaning the step has not happened (yet).
+ * The client's timestamp is kept as it was sent, so the client can match it against its own clock.
+ * Kept as a plain aggregate so that it can be passed through a {@link CommandMailbox}.
+ */
+struct CommandTrace {
+    char correlationId[COMMAND_CORRELATION_ID_LENGTH + 1];
+    int64_t clientTime;
+    int64_t received;
+    int64_t dequeued;
+    int64_t actuationStarted;
+    int64_t actuationCompleted;
+
+    /**
+     * @brief Starts tracing a command received at the given time; the correlation ID may be null.
+     */
+    static CommandTrace receive(const char* correlationId, int64_t clientTime, time_point<system_clock> time) {
+        CommandTrace trace {};
+        if (correlationId != nullptr) {
+            // Longer IDs are truncated, the terminating zero is already in place
+            size_t length = 0;
+            while (length < COMMAND_CORRELATION_ID_LENGTH && correlationId[length] != '\0') {
+                length++;
+            }
+            memcpy(trace.correlationId, correlationId, length);
+        }
+        trace.clientTime = clientTime;
+        trace.received = toMicros(time);
+        return trace;
+    }
+
+    /**
+     * @brief Whether this traces an actual command, i.e. it was received.
+     */
+    bool isActive() const {
+        return received != 0;
+    }
+
+    bool hasCorrelationId() const {
+        return correlationId[0] != '\0';
+    }
+
+    static int64_t toMicros(time_point<system_clock> time) {
+        return std::chrono::duration_cast<microseconds>(time.time_since_epoch()).count();
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The supported DHT sensor models.
+ */
+enum class DhtModel : uint8_t {
+    DHT11 = 1,
+    DHT22 = 2,
+    AM2302 = 3
+};
+
+/**
+ * @brief A period of the data line staying at the same level.
+ */
+struct DhtPulse {
+    uint8_t level;
+
+    /**
+     * @brief Duration in microseconds.
+     */
+    uint16_t duration;
+};
+
+/**
+ * @brief The number of bits in a DHT frame: 16 bits of humidity, 16 bits of temperature and an 8-bit checksum.
+ */
+const size_t DHT_FRAME_BITS = 40;
+
+/**
+ * @brief High pulses longer than this are ones, shorter ones are zeros; zeros last 26-28 µs, ones 70 µs.
+ */
+const uint16_t DHT_BIT_THRESHOLD_US = 50;
+
+/**
+ * @brief High pulses longer than this are not part of the frame, e.g. the idle line.
+ */
+const uint16_t DHT_MAX_HIGH_US = 200;
+
+/**
+ * @brief Decodes the single-wire protocol of DHT humidity and temperature sensors.
+ *
+ * After the start signal, the sensor responds with a low and a high pulse of 80 µs each,
+ * then sends each bit as a 50 µs low pulse followed by a high pulse whose length encodes the bit.
+ */
+class Dht {
+public:
+    /**
+     * @brief Decodes the frame from the pulses captured on the data line.
+     *
+     * Only high pulses that follow a low pulse are considered, so it does not matter whether the capture starts
+     * with the idle line or with the response; the last 40 of them are the bits.
+     *
+     * @return false if the capture is too short.
+     */
+    static bool decodeFrame(const DhtPulse* pulses, size_t count, uint8_t* data) {
+        size_t highCount = 0;
+        for (size_t i = 1; i < count; i++) {
+            if (isBitPulse(pulses, i)) {
+                highCount++;
+            }
+        }
+        if (highCount < DHT_FRAME_BITS) {
+            return false;
+        }
+        size_t skip = highCount - DHT_FRAME_BITS;
+        size_t bit = 0;
+        for (size_t i = 0; i < DHT_FRAME_BITS / 8; i++) {
+            data[i] = 0;
+        }
+        for (size_t i = 1; i < count; i++) {
+            if (!isBitPulse(pulses, i)) {
+                continue;
+            }
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+            if (pulses[i].duration > DHT_BIT_THRESHOLD_US) {
+                data[bit / 8] |= 0x80 >> (bit % 8);
+            }
+            bit++;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Converts a decoded frame to °C and %RH.
+     *
+     * @return false if the checksum does not match.
+     */
+    static bool parseFrame(DhtModel model, const uint8_t* data, double& temperature, double& humidity) {
+        if (static_cast<uint8_t>(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+            return false;
+        }
+        switch (model) {
+            case DhtModel::DHT11:
+                humidity = data[0] + data[1] * 0.1;
+                temperature = data[2] + (data[3] & 0x7F) * 0.1;
+                if (data[3] & 0x80) {
+                    temperature = -temperature;
+                }
+                break;
+            default:
+                humidity = ((data[0] << 8) | data[1]) * 0.1;
+                temperature = (((data[2] & 0x7F) << 8) | data[3]) * 0.1;
+                if (data[2] & 0x80) {
+                    temperature = -temperature;
+                }
+                break;
+        }
+        return true;
+    }
+
+private:
+    static bool isBitPulse(const DhtPulse* pulses, size_t index) {
+        return pulses[index].level == 1
+            && pulses[index - 1].level == 0
+            && pulses[index].duration <= DHT_MAX_HIGH_US;
+    }
+};
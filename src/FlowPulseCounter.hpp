@@ -0,0 +1,44 @@
+#pragma once
+
+#include <driver/pcnt.h>
+
+/**
+ * @brief Counts the pulses of the flow meter in hardware, so that no pulse is missed while the CPU is busy.
+ */
+class FlowPulseCounter {
+public:
+    static void begin(gpio_num_t flowPin) {
+        pcnt_config_t pcntFreqConfig = {};
+        pcntFreqConfig.pulse_gpio_num = flowPin;
+        pcntFreqConfig.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+        pcntFreqConfig.lctrl_mode = PCNT_MODE_KEEP;
+        pcntFreqConfig.hctrl_mode = PCNT_MODE_KEEP;
+        pcntFreqConfig.pos_mode = PCNT_COUNT_INC;
+        pcntFreqConfig.neg_mode = PCNT_COUNT_DIS;
+        pcntFreqConfig.unit = PCNT_UNIT_0;
+        pcntFreqConfig.channel = PCNT_CHANNEL_0;
+
+        pcnt_unit_config(&pcntFreqConfig);
+        pcnt_intr_disable(PCNT_UNIT_0);
+        pcnt_set_filter_value(PCNT_UNIT_0, 1023);
+        pcnt_filter_enable(PCNT_UNIT_0);
+        pcnt_counter_clear(PCNT_UNIT_0);
+    }
+
+    /**
+     * @brief The number of pulses counted since the previous call.
+     */
+    static int16_t take() {
+        int16_t pulses;
+        pcnt_get_counter_value(PCNT_UNIT_0, &pulses);
+        pcnt_counter_clear(PCNT_UNIT_0);
+        return pulses;
+    }
+
+    /**
+     * @brief The volume in liters the given number of pulses stand for, where Q is the pulse frequency at 1 liter / min.
+     */
+    static double toVolume(int16_t pulses, double qFactor) {
+        return pulses / qFactor / 60.0f;
+    }
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::time_point;
+
+/**
+ * @brief The fraction of the expected change in flow rate that needs to be measured for the change to be verified.
+ */
+const double FLOW_VERIFIER_RATE_CHANGE_THRESHOLD = 0.5;
+
+/**
+ * @brief Verifies that flow starts, stops or changes after a valve actuation, and decides when to retry.
+ *
+ * Flow is considered started when the flow meter has seen flow after the actuation,
+ * and stopped when it has not seen any flow for a quiet period.
+ * When other zones keep flowing through the actuation, the measured flow rate is expected to change
+ * by at least {@link FLOW_VERIFIER_RATE_CHANGE_THRESHOLD} of the nominal flow rate of the actuated zones instead.
+ * When neither happens within the verification window, the actuation should be retried
+ * with the drive pulse stretched by the escalation factor, up to the maximum number of attempts.
+ */
+template <typename Clock>
+class FlowVerifier {
+public:
+    enum class Result {
+        IDLE,
+        PENDING,
+        VERIFIED,
+        RETRY,
+        FAILED
+    };
+
+    /**
+     * @param window how long to wait for the flow to change after each attempt.
+     * @param quietPeriod how long without flow counts as flow stopped.
+     * @param maxAttempts the maximum number of drive pulses, including the first one.
+     * @param escalation the factor the pulse is stretched by for each retry.
+     */
+    FlowVerifier(milliseconds window, milliseconds quietPeriod, int maxAttempts, double escalation)
+        : window(window)
+        , quietPeriod(quietPeriod)
+        , maxAttempts(maxAttempts)
+        , escalation(escalation) {
+    }
+
+    void start(bool expectFlow, time_point<Clock> now) {
+        this->expectFlow = expectFlow;
+        rateChange = false;
+        begin(now);
+    }
+
+    /**
+     * @brief Starts verifying that the flow rate changes from the baseline by the expected amount, in liters / min.
+     *
+     * @param expectedChange the nominal change in flow rate, must not be zero.
+     */
+    void startRateChange(double baselineRate, double expectedChange, time_point<Clock> now) {
+        this->expectFlow = expectedChange > 0;
+        this->baselineRate = baselineRate;
+        this->expectedChange = expectedChange;
+        rateChange = true;
+        begin(now);
+    }
+
+    void cancel() {
+        active = false;
+    }
+
+    bool isActive() const {
+        return active;
+    }
+
+    /**
+     * @param lastSeenFlow the last time the flow meter registered any flow.
+     * @param flowRate the last measured flow rate in liters / min, only used when verifying a rate change.
+     */
+    Result update(time_point<Clock> now, time_point<Clock> lastSeenFlow, double flowRate = 0.0) {
+        if (!active) {
+            return Result::IDLE;
+        }
+        lastUpdate = now;
+
+        if (rateChange) {
+            if ((flowRate - baselineRate) / expectedChange >= FLOW_VERIFIER_RATE_CHANGE_THRESHOLD) {
+                return verified(now);
+            }
+        } else if (expectFlow) {
+            if (lastSeenFlow > actuationTime) {
+                return verified(lastSeenFlow);
+            }
+        } else {
+            if (now - lastSeenFlow >= quietPeriod) {
+                return verified(lastSeenFlow > actuationTime ? lastSeenFlow : actuationTime);
+            }
+        }
+
+        if (now - attemptTime < window) {
+            return Result::PENDING;
+        }
+        if (attempts >= maxAttempts) {
+            active = false;
+            latency = duration_cast<milliseconds>(now - actuationTime);
+            return Result::FAILED;
+        }
+        attempts++;
+        attemptTime = now;
+        pulseScale *= escalation;
+        return Result::RETRY;
+    }
+
+    /**
+     * @brief The latest time at which {@link #update} needs to be called next for the result to change,
+     * assuming no new flow is seen until then.
+     *
+     * The flow rate is not tracked here, so a rate change is polled twice per quiet period.
+     */
+    time_point<Clock> getDeadline(time_point<Clock> lastSeenFlow) const {
+        if (!active) {
+            return time_point<Clock>::max();
+        }
+        auto deadline = attemptTime + window;
+        if (rateChange) {
+            deadline = std::min(deadline, lastUpdate + quietPeriod / 2);
+        } else if (!expectFlow) {
+            deadline = std::min(deadline, lastSeenFlow + quietPeriod);
+        }
+        return deadline;
+    }
+
+    bool isExpectingFlow() const {
+        return expectFlow;
+    }
+
+    /**
+     * @brief The time it took from the first actuation until the flow changed, or until verification gave up.
+     */
+    milliseconds getLatency() const {
+        return latency;
+    }
+
+    int getAttempts() const {
+        return attempts;
+    }
+
+    /**
+     * @brief The factor to stretch the drive pulse by for the current attempt.
+     */
+    double getPulseScale() const {
+        return pulseScale;
+    }
+
+    bool isVerifyingRateChange() const {
+        return rateChange;
+    }
+
+private:
+    void begin(time_point<Clock> now) {
+        actuationTime = now;
+        attemptTime = now;
+        lastUpdate = now;
+        attempts = 1;
+        pulseScale = 1.0;
+        latency = milliseconds::zero();
+        active = true;
+    }
+
+    Result verified(time_point<Clock> changeTime) {
+        active = false;
+        latency = duration_cast<milliseconds>(changeTime - actuationTime);
+        return Result::VERIFIED;
+    }
+
+    milliseconds window;
+    milliseconds quietPeriod;
+    int maxAttempts;
+    double escalation;
+
+    bool active = false;
+    bool expectFlow = false;
+    bool rateChange = false;
+    double baselineRate = 0.0;
+    double expectedChange = 0.0;
+    time_point<Clock> actuationTime;
+    time_point<Clock> attemptTime;
+    time_point<Clock> lastUpdate;
+    int attempts = 0;
+    double pulseScale = 1.0;
+    milliseconds latency = milliseconds::zero();
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <list>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <Telemetry.hpp>
+
+#include "Tracer.hpp"
+
+using namespace farmhub::client;
+
+/**
+ * @brief Reports the state of the heap and the stack usage of tasks under <code>diagnostics</code>.
+ *
+ * Fragmentation is the share of free heap that is not part of the largest free block, in percent;
+ * a growing fragmentation with stable free heap means long-running allocations are breaking up the heap.
+ * The stack high-water mark is the least amount of stack, in bytes, that has remained free since the task started.
+ */
+class HeapDiagnosticsProvider
+    : public TelemetryProvider {
+public:
+    /**
+     * @brief Reports the stack high-water mark of the given task under the name.
+     */
+    void watchTask(const char* name, TaskHandle_t task) {
+        if (task != nullptr) {
+            tasks.push_back({ name, task });
+        }
+    }
+
+    void populateTelemetry(JsonObject& json) override {
+        TRACE_SCOPE("heap/telemetry");
+        JsonObject diagnosticsJson = json.containsKey("diagnostics")
+            ? json["diagnostics"].as<JsonObject>()
+            : json.createNestedObject("diagnostics");
+
+        uint32_t freeHeap = ESP.getFreeHeap();
+        uint32_t largestBlock = ESP.getMaxAllocHeap();
+        JsonObject heapJson = diagnosticsJson.createNestedObject("heap");
+        heapJson["free"] = freeHeap;
+        heapJson["largestBlock"] = largestBlock;
+        heapJson["minFree"] = ESP.getMinFreeHeap();
+        heapJson["fragmentation"] = freeHeap == 0
+            ? 0
+            : 100 - largestBlock * 100 / freeHeap;
+
+        JsonObject stacksJson = diagnosticsJson.createNestedObject("stacks");
+        for (auto& task : tasks) {
+            stacksJson[task.name] = uxTaskGetStackHighWaterMark(task.handle);
+        }
+    }
+
+private:
+    struct WatchedTask {
+        const char* name;
+        TaskHandle_t handle;
+    };
+
+    std::list<WatchedTask> tasks;
+};
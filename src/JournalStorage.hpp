@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Sector-erasable storage backing a {@link TelemetryJournal}, with NOR flash semantics.
+ *
+ * Erasing a sector sets all its bytes to <code>0xFF</code>; writing can only clear bits.
+ * Offsets are absolute from the start of the storage.
+ */
+class JournalStorage {
+public:
+    virtual size_t getSectorSize() const = 0;
+    virtual size_t getSectorCount() const = 0;
+    virtual bool erase(size_t sector) = 0;
+    virtual bool write(size_t offset, const void* data, size_t length) = 0;
+    virtual bool read(size_t offset, void* data, size_t length) = 0;
+};
+
+/**
+ * @brief Storage in RAM that behaves like NOR flash, and counts erases per sector.
+ */
+class MemoryJournalStorage : public JournalStorage {
+public:
+    MemoryJournalStorage(size_t sectorSize, size_t sectorCount)
+        : sectorSize(sectorSize)
+        , sectorCount(sectorCount)
+        , data(sectorSize * sectorCount, 0xFF)
+        , eraseCounts(sectorCount, 0) {
+    }
+
+    size_t getSectorSize() const override {
+        return sectorSize;
+    }
+
+    size_t getSectorCount() const override {
+        return sectorCount;
+    }
+
+    bool erase(size_t sector) override {
+        if (sector >= sectorCount) {
+            return false;
+        }
+        std::fill(data.begin() + sector * sectorSize, data.begin() + (sector + 1) * sectorSize, 0xFF);
+        eraseCounts[sector]++;
+        return true;
+    }
+
+    bool write(size_t offset, const void* source, size_t length) override {
+        if (offset + length > data.size()) {
+            return false;
+        }
+        auto bytes = static_cast<const uint8_t*>(source);
+        for (size_t i = 0; i < length; i++) {
+            data[offset + i] &= bytes[i];
+        }
+        return true;
+    }
+
+    bool read(size_t offset, void* target, size_t length) override {
+        if (offset + length > data.size()) {
+            return false;
+        }
+        memcpy(target, data.data() + offset, length);
+        return true;
+    }
+
+    size_t getEraseCount(size_t sector) const {
+        return eraseCounts[sector];
+    }
+
+    /**
+     * @brief Direct access to the contents, e.g. to simulate corruption.
+     */
+    std::vector<uint8_t>& getData() {
+        return data;
+    }
+
+private:
+    const size_t sectorSize;
+    const size_t sectorCount;
+    std::vector<uint8_t> data;
+    std::vector<size_t> eraseCounts;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+using std::chrono::microseconds;
+
+/**
+ * @brief The weight of the latest measurement in the moving average.
+ */
+const double LATENCY_AVERAGE_WEIGHT = 0.125;
+
+/**
+ * @brief The last, maximum and exponentially weighted moving average of a series of latency measurements.
+ */
+class LatencyStats {
+public:
+    void record(microseconds latency) {
+        last = latency;
+        if (count == 0) {
+            average = latency.count();
+        } else {
+            average += LATENCY_AVERAGE_WEIGHT * (latency.count() - average);
+        }
+        if (latency > max) {
+            max = latency;
+        }
+        count++;
+    }
+
+    microseconds getLast() const {
+        return last;
+    }
+
+    microseconds getMax() const {
+        return max;
+    }
+
+    microseconds getAverage() const {
+        return microseconds { static_cast<int64_t>(average) };
+    }
+
+    uint32_t getCount() const {
+        return count;
+    }
+
+private:
+    microseconds last = microseconds::zero();
+    microseconds max = microseconds::zero();
+    double average = 0;
+    uint32_t count = 0;
+};
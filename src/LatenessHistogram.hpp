@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+using std::chrono::milliseconds;
+
+/**
+ * @brief The upper bounds of the histogram buckets in milliseconds; anything longer goes in an extra last bucket.
+ */
+const int64_t LATENESS_BUCKET_BOUNDS[] = { 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000 };
+
+const size_t LATENESS_BUCKETS = sizeof(LATENESS_BUCKET_BOUNDS) / sizeof(LATENESS_BUCKET_BOUNDS[0]) + 1;
+
+/**
+ * @brief A histogram of how late things happen, with percentiles in constant space.
+ *
+ * Percentiles are reported as the upper bound of the bucket they fall in, and never more than the maximum.
+ * A plain aggregate so that it can be kept in RTC memory; value-initialize it to start empty.
+ */
+class LatenessHistogram {
+public:
+    void add(milliseconds lateness) {
+        if (lateness < milliseconds::zero()) {
+            lateness = milliseconds::zero();
+        }
+        size_t bucket = 0;
+        while (bucket < LATENESS_BUCKETS - 1 && lateness.count() > LATENESS_BUCKET_BOUNDS[bucket]) {
+            bucket++;
+        }
+        buckets[bucket]++;
+        count++;
+        if (lateness > max) {
+            max = lateness;
+        }
+    }
+
+    /**
+     * @param percentile between 0 and 100.
+     */
+    milliseconds getPercentile(double percentile) const {
+        if (count == 0) {
+            return milliseconds::zero();
+        }
+        // The rank of the sample at the percentile, counting from 1
+        uint32_t rank = static_cast<uint32_t>(percentile / 100 * count + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        uint32_t seen = 0;
+        for (size_t bucket = 0; bucket < LATENESS_BUCKETS - 1; bucket++) {
+            seen += buckets[bucket];
+            if (seen >= rank) {
+                return std::min(milliseconds { LATENESS_BUCKET_BOUNDS[bucket] }, max);
+            }
+        }
+        return max;
+    }
+
+    milliseconds getMax() const {
+        return max;
+    }
+
+    uint32_t getCount() const {
+        return count;
+    }
+
+private:
+    uint32_t buckets[LATENESS_BUCKETS];
+    uint32_t count;
+    milliseconds max;
+};
+
+static_assert(std::is_trivial<LatenessHistogram>::value, "LatenessHistogram must be kept in RTC memory");
@@ -1,18 +1,23 @@
 #pragma once
 
 #include <chrono>
-#include <driver/pcnt.h>
 
 #include <Task.hpp>
 #include <Telemetry.hpp>
 
+#include "FlowPulseCounter.hpp"
+#include "ProfiledTask.hpp"
+#include "TelemetrySnapshotProvider.hpp"
+#include "Tracer.hpp"
+
 using namespace std::chrono;
 using namespace farmhub::client;
 
 class MeterHandler
-    : public BaseTask,
+    : public ProfiledTask,
       public BaseSleepListener,
-      public TelemetryProvider {
+      public TelemetryProvider,
+      public TelemetrySnapshotProvider {
 public:
     class Config
         : public NamedConfigurationSection {
@@ -27,7 +32,7 @@ public:
 
     MeterHandler(
         TaskContainer& tasks, SleepHandler& sleep, const Config& config, std::function<void()> onSleep)
-        : BaseTask(tasks, "Flow meter")
+        : ProfiledTask(tasks, "Flow meter")
         , BaseSleepListener(sleep)
         , config(config)
         , onSleep(onSleep) {
@@ -39,43 +44,68 @@ public:
         Serial.printf("Initializing flow meter on pin %d with Q = %f\n", flowPin, qFactor);
 
         pinMode(flowPin, INPUT);
-
-        pcnt_config_t pcntFreqConfig = {};
-        pcntFreqConfig.pulse_gpio_num = flowPin;
-        pcntFreqConfig.ctrl_gpio_num = PCNT_PIN_NOT_USED;
-        pcntFreqConfig.lctrl_mode = PCNT_MODE_KEEP;
-        pcntFreqConfig.hctrl_mode = PCNT_MODE_KEEP;
-        pcntFreqConfig.pos_mode = PCNT_COUNT_INC;
-        pcntFreqConfig.neg_mode = PCNT_COUNT_DIS;
-        pcntFreqConfig.unit = PCNT_UNIT_0;
-        pcntFreqConfig.channel = PCNT_CHANNEL_0;
-
-        pcnt_unit_config(&pcntFreqConfig);
-        pcnt_intr_disable(PCNT_UNIT_0);
-        pcnt_set_filter_value(PCNT_UNIT_0, 1023);
-        pcnt_filter_enable(PCNT_UNIT_0);
-        pcnt_counter_clear(PCNT_UNIT_0);
+        FlowPulseCounter::begin(flowPin);
 
         auto now = boot_clock::now();
         lastMeasurement = now;
         lastSeenFlow = now;
         lastPublished = now;
+        lastSnapshot = now;
+    }
+
+    /**
+     * @brief The last time the meter has registered any flow; safe to call from any task.
+     */
+    time_point<boot_clock> getLastSeenFlow() const {
+        portENTER_CRITICAL(&measurementLock);
+        auto lastSeenFlow = this->lastSeenFlow;
+        portEXIT_CRITICAL(&measurementLock);
+        return lastSeenFlow;
+    }
+
+    /**
+     * @brief The flow rate of the last measurement in liters / min; safe to call from any task.
+     */
+    double getFlowRate() const {
+        portENTER_CRITICAL(&measurementLock);
+        auto flowRate = this->flowRate;
+        portEXIT_CRITICAL(&measurementLock);
+        return flowRate;
+    }
+
+    seconds getMeasurementFrequency() const {
+        return config.measurementFrequency.get();
+    }
+
+    /**
+     * @brief Reports the volume in liters, and the flow rate over the given time in liters / min.
+     */
+    static void populateVolume(JsonObject& json, double volume, boot_clock::duration elapsed) {
+        // Volume is measured in liters
+        json["volume"] = volume;
+        auto duration = duration_cast<microseconds>(elapsed);
+        if (duration > microseconds::zero()) {
+            // Flow rate is measured in in liters / min
+            json["flowRate"] = volume / duration.count() * 1000 * 1000 * 60;
+        }
     }
 
 protected:
     const Schedule loop(const Timing& timing) override {
+        PROFILE_LOOP();
         auto now = boot_clock::now();
         milliseconds elapsed = duration_cast<milliseconds>(now - lastMeasurement);
         if (elapsed.count() == 0) {
-            return sleepFor(config.measurementFrequency.get());
+            return profiledSleepFor(config.measurementFrequency.get());
         }
         lastMeasurement = now;
 
-        int16_t pulses;
-        pcnt_get_counter_value(PCNT_UNIT_0, &pulses);
-        pcnt_counter_clear(PCNT_UNIT_0);
+        int16_t pulses = FlowPulseCounter::take();
 
         if (pulses == 0) {
+            portENTER_CRITICAL(&measurementLock);
+            flowRate = 0.0;
+            portEXIT_CRITICAL(&measurementLock);
             if (config.noFlowTimeout.get() > seconds::zero()) {
                 auto timeSinceLastFlow = now - lastSeenFlow;
                 if (timeSinceLastFlow > config.noFlowTimeout.get()) {
@@ -85,13 +115,19 @@ protected:
                 }
             }
         } else {
-            double currentVolume = pulses / qFactor / 60.0f;
+            double currentVolume = FlowPulseCounter::toVolume(pulses, qFactor);
+            double currentFlowRate = currentVolume / (elapsed.count() / 1000.0f / 60.0f);
             Serial.printf("Counted %d pulses, %.2f l/min, %.2f l\n",
-                pulses, currentVolume / (elapsed.count() / 1000.0f / 60.0f), currentVolume);
+                pulses, currentFlowRate, currentVolume);
             volume += currentVolume;
+            snapshotVolume += currentVolume;
+            // Read by the valve actuation task, the 64-bit time point must not be torn
+            portENTER_CRITICAL(&measurementLock);
             lastSeenFlow = now;
+            flowRate = currentFlowRate;
+            portEXIT_CRITICAL(&measurementLock);
         }
-        return sleepFor(config.measurementFrequency.get());
+        return profiledSleepFor(config.measurementFrequency.get());
     }
 
     void onDeepSleep(SleepEvent& event) override {
@@ -100,17 +136,21 @@ protected:
     }
 
     void populateTelemetry(JsonObject& json) override {
-        // Volume is measured in liters
-        json["volume"] = volume;
-        auto duration = duration_cast<microseconds>(lastMeasurement - lastPublished);
-        if (duration > microseconds::zero()) {
-            // Flow rate is measured in in liters / min
-            json["flowRate"] = volume / duration.count() * 1000 * 1000 * 60;
-        }
+        TRACE_SCOPE("meter/telemetry");
+        populateVolume(json, volume, lastMeasurement - lastPublished);
         volume = 0.0;
         lastPublished = lastMeasurement;
     }
 
+    /**
+     * @brief Reports the volume since the previous snapshot, counted separately from the volume published as telemetry.
+     */
+    void populateSnapshot(JsonObject& json) override {
+        populateVolume(json, snapshotVolume, lastMeasurement - lastSnapshot);
+        snapshotVolume = 0.0;
+        lastSnapshot = lastMeasurement;
+    }
+
 private:
     const Config& config;
     std::function<void()> onSleep;
@@ -121,4 +161,12 @@ private:
     time_point<boot_clock> lastSeenFlow;
     time_point<boot_clock> lastPublished;
     double volume = 0.0;
+    time_point<boot_clock> lastSnapshot;
+    double snapshotVolume = 0.0;
+
+    /**
+     * @brief Guards the measurements read from other tasks.
+     */
+    mutable portMUX_TYPE measurementLock = portMUX_INITIALIZER_UNLOCKED;
+    double flowRate = 0.0;
 };
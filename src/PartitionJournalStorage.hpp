@@ -0,0 +1,49 @@
+#pragma once
+
+#include <esp_partition.h>
+
+#include "JournalStorage.hpp"
+
+/**
+ * @brief Journal storage in a raw data partition of the flash.
+ */
+class PartitionJournalStorage : public JournalStorage {
+public:
+    /**
+     * @return false if the partition cannot be found.
+     */
+    bool begin(const char* label) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (partition == nullptr) {
+            Serial.printf("Could not find partition '%s' for the journal\n", label);
+            return false;
+        }
+        Serial.printf("Using partition '%s' of %d bytes for the journal\n", label, (int) partition->size);
+        return true;
+    }
+
+    size_t getSectorSize() const override {
+        return SPI_FLASH_SEC_SIZE;
+    }
+
+    size_t getSectorCount() const override {
+        return partition == nullptr
+            ? 0
+            : partition->size / SPI_FLASH_SEC_SIZE;
+    }
+
+    bool erase(size_t sector) override {
+        return esp_partition_erase_range(partition, sector * SPI_FLASH_SEC_SIZE, SPI_FLASH_SEC_SIZE) == ESP_OK;
+    }
+
+    bool write(size_t offset, const void* data, size_t length) override {
+        return esp_partition_write(partition, offset, data, length) == ESP_OK;
+    }
+
+    bool read(size_t offset, void* data, size_t length) override {
+        return esp_partition_read(partition, offset, data, length) == ESP_OK;
+    }
+
+private:
+    const esp_partition_t* partition = nullptr;
+};
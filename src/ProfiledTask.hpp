@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+
+#include <Task.hpp>
+
+using namespace farmhub::client;
+using std::chrono::microseconds;
+
+#ifdef PROFILE_TASKS
+
+#include <list>
+
+#include <Telemetry.hpp>
+
+#include "TaskProfile.hpp"
+
+/**
+ * @brief A task whose loops are profiled; put {@link PROFILE_LOOP} at the start of its loop.
+ *
+ * Loops must end with {@link #profiledSleepFor} or {@link #profiledSleepIndefinitely} so that the requested
+ * sleep is recorded; the plain {@link BaseTask} variants are hidden to make them hard to bypass.
+ * Profiling only happens when built with <code>PROFILE_TASKS</code>, otherwise it compiles out completely.
+ */
+class ProfiledTask
+    : public BaseTask {
+public:
+    ProfiledTask(TaskContainer& tasks, const String& name)
+        : BaseTask(tasks, name)
+        , profileName(name) {
+        getProfiles().push_back(&profile);
+    }
+
+    /**
+     * @brief The profiles of all profiled tasks.
+     */
+    static std::list<TaskProfile*>& getProfiles() {
+        static std::list<TaskProfile*> profiles;
+        return profiles;
+    }
+
+protected:
+    const Schedule profiledSleepFor(microseconds delay) {
+        profile.recordSleep(delay);
+        return BaseTask::sleepFor(delay);
+    }
+
+    const Schedule profiledSleepIndefinitely() {
+        profile.recordSleep(microseconds { -1 });
+        return BaseTask::sleepIndefinitely();
+    }
+
+    const String profileName;
+    TaskProfile profile { profileName.c_str() };
+
+private:
+    using BaseTask::sleepFor;
+    using BaseTask::sleepIndefinitely;
+};
+
+/**
+ * @brief The profile of a loop running on its own FreeRTOS task instead of a {@link BaseTask},
+ * reported along with the profiled tasks; put {@link PROFILE_LOOP_OF} at the start of the loop.
+ */
+class LoopProfile
+    : public TaskProfile {
+public:
+    LoopProfile(const char* name)
+        : TaskProfile(name) {
+        ProfiledTask::getProfiles().push_back(this);
+    }
+};
+
+/**
+ * @brief Measures the duration of a loop with the CPU cycle counter, for as long as it is in scope.
+ *
+ * The counter wraps around every 2^32 cycles, i.e. about 18 seconds at 240 MHz, which is far longer than any loop should take.
+ */
+class LoopProfileScope {
+public:
+    LoopProfileScope(TaskProfile& profile)
+        : profile(profile)
+        , start(ESP.getCycleCount()) {
+    }
+
+    ~LoopProfileScope() {
+        uint32_t cycles = ESP.getCycleCount() - start;
+        profile.recordLoop(microseconds { cycles / ESP.getCpuFreqMHz() });
+    }
+
+private:
+    TaskProfile& profile;
+    const uint32_t start;
+};
+
+#define PROFILE_LOOP_OF(loopProfile) LoopProfileScope loopProfileScope(loopProfile)
+#define PROFILE_LOOP() PROFILE_LOOP_OF(profile)
+
+/**
+ * @brief Reports the profiles of all profiled tasks under <code>diagnostics.tasks</code>.
+ */
+class TaskDiagnosticsProvider
+    : public TelemetryProvider {
+public:
+    void populateTelemetry(JsonObject& json) override {
+        JsonObject diagnosticsJson = json.containsKey("diagnostics")
+            ? json["diagnostics"].as<JsonObject>()
+            : json.createNestedObject("diagnostics");
+        JsonObject tasksJson = diagnosticsJson.createNestedObject("tasks");
+        for (auto profile : ProfiledTask::getProfiles()) {
+            JsonObject taskJson = tasksJson.createNestedObject(profile->getName());
+            taskJson["wakes"] = profile->getWakes();
+            taskJson["totalLoop"] = profile->getTotalLoop().count();
+            taskJson["maxLoop"] = profile->getMaxLoop().count();
+            taskJson["lastSleep"] = profile->getLastSleep().count();
+            JsonArray histogramJson = taskJson.createNestedArray("histogram");
+            for (size_t bucket = 0; bucket < TASK_PROFILE_BUCKETS; bucket++) {
+                histogramJson.add(profile->getHistogram(bucket));
+            }
+        }
+    }
+};
+
+#else
+
+class ProfiledTask
+    : public BaseTask {
+public:
+    ProfiledTask(TaskContainer& tasks, const String& name)
+        : BaseTask(tasks, name) {
+    }
+
+protected:
+    const Schedule profiledSleepFor(microseconds delay) {
+        return BaseTask::sleepFor(delay);
+    }
+
+    const Schedule profiledSleepIndefinitely() {
+        return BaseTask::sleepIndefinitely();
+    }
+
+private:
+    using BaseTask::sleepFor;
+    using BaseTask::sleepIndefinitely;
+};
+
+class LoopProfile {
+public:
+    LoopProfile(const char* name) {
+    }
+
+    void recordSleep(microseconds sleep) {
+    }
+};
+
+#define PROFILE_LOOP_OF(loopProfile)
+#define PROFILE_LOOP()
+
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief Sequences drive pulses for a valve that can only perform one pulse at a time.
+ *
+ * Requests arriving while a pulse is in progress are queued instead of blocking the caller.
+ * Only the latest queued request is kept, and it is dropped if it matches the pulse in progress.
+ *
+ * The sequencer itself is not thread-safe, callers must serialize access to it.
+ */
+class PulseSequencer {
+public:
+    enum class Direction : int8_t {
+        CLOSE = -1,
+        NONE = 0,
+        OPEN = 1
+    };
+
+    PulseSequencer() = default;
+
+    /**
+     * @brief Requests a pulse in the given direction.
+     *
+     * @return the direction to start driving now, or NONE if the request has been queued.
+     */
+    Direction request(Direction direction) {
+        if (direction == Direction::NONE) {
+            return Direction::NONE;
+        }
+        if (active == Direction::NONE) {
+            active = direction;
+            return direction;
+        }
+        pending = direction == active
+            ? Direction::NONE
+            : direction;
+        return Direction::NONE;
+    }
+
+    /**
+     * @brief Marks the active pulse as finished.
+     *
+     * @return the direction of the next pulse to start driving, or NONE if there is nothing queued.
+     */
+    Direction complete() {
+        active = pending;
+        pending = Direction::NONE;
+        return active;
+    }
+
+    /**
+     * @brief Drops both the active and the queued pulse.
+     */
+    void cancel() {
+        active = Direction::NONE;
+        pending = Direction::NONE;
+    }
+
+    bool isBusy() const {
+        return active != Direction::NONE;
+    }
+
+    Direction getActive() const {
+        return active;
+    }
+
+    Direction getPending() const {
+        return pending;
+    }
+
+private:
+    Direction active = Direction::NONE;
+    Direction pending = Direction::NONE;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief A value kept in RTC memory across deep sleep, guarded by a validity marker and a checksum.
+ *
+ * RTC memory is zeroed on power-up, but may hold garbage after a brown-out or a firmware update
+ * that moves things around. A value is only loaded back if both the marker and the checksum match.
+ * Must be declared with <code>RTC_DATA_ATTR</code>, and thus must stay a plain aggregate.
+ */
+template <typename T>
+struct RtcStored {
+    static const uint32_t VALID_MARKER = 0x52544331;
+
+    uint32_t marker;
+    T value;
+    uint32_t checksum;
+
+    void store(const T& value) {
+        memcpy(&this->value, &value, sizeof(T));
+        checksum = calculateChecksum();
+        marker = VALID_MARKER;
+    }
+
+    /**
+     * @return false if nothing valid has been stored.
+     */
+    bool load(T& value) const {
+        if (!isValid()) {
+            return false;
+        }
+        memcpy(&value, &this->value, sizeof(T));
+        return true;
+    }
+
+    bool isValid() const {
+        return marker == VALID_MARKER && checksum == calculateChecksum();
+    }
+
+    void invalidate() {
+        marker = 0;
+    }
+
+private:
+    /**
+     * @brief FNV-1a hash of the stored bytes.
+     */
+    uint32_t calculateChecksum() const {
+        auto bytes = reinterpret_cast<const uint8_t*>(&value);
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+/**
+ * @brief The running minimum, maximum, mean and variance of a series of samples.
+ *
+ * Uses Welford's algorithm, which takes constant space and stays numerically stable
+ * even when the samples are large compared to their spread.
+ */
+class RunningAggregate {
+public:
+    /**
+     * @brief Folds the sample into the aggregate; NaN samples, i.e. failed readings, are ignored.
+     */
+    void add(double value) {
+        if (std::isnan(value)) {
+            return;
+        }
+        count++;
+        double delta = value - mean;
+        mean += delta / count;
+        m2 += delta * (value - mean);
+        if (count == 1 || value < min) {
+            min = value;
+        }
+        if (count == 1 || value > max) {
+            max = value;
+        }
+    }
+
+    void reset() {
+        count = 0;
+        mean = 0;
+        m2 = 0;
+        min = 0;
+        max = 0;
+    }
+
+    size_t getCount() const {
+        return count;
+    }
+
+    /**
+     * @brief The mean of the samples, or NaN if there are none.
+     */
+    double getMean() const {
+        return count > 0
+            ? mean
+            : NAN;
+    }
+
+    double getMin() const {
+        return count > 0
+            ? min
+            : NAN;
+    }
+
+    double getMax() const {
+        return count > 0
+            ? max
+            : NAN;
+    }
+
+    /**
+     * @brief The sample variance, or 0 if there are fewer than two samples.
+     */
+    double getVariance() const {
+        return count > 1
+            ? m2 / (count - 1)
+            : 0;
+    }
+
+private:
+    size_t count = 0;
+    double mean = 0;
+    double m2 = 0;
+    double min = 0;
+    double max = 0;
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <functional>
+
+#include <esp_sleep.h>
+#include <WiFi.h>
+
+#include <Events.hpp>
+#include <Task.hpp>
+
+#include "FlowPulseCounter.hpp"
+#include "MeterHandler.hpp"
+#include "ProfiledTask.hpp"
+#include "RtcStored.hpp"
+#include "SampleRing.hpp"
+#include "Tracer.hpp"
+
+using namespace std::chrono;
+using namespace farmhub::client;
+
+/**
+ * @brief The number of samples kept in RTC memory between uploads.
+ */
+const size_t SAMPLE_BATCH_CAPACITY = 48;
+
+/**
+ * @brief Everything a short wake needs to know to take a sample without loading the configuration.
+ */
+struct SleepCycle {
+    /**
+     * @brief The configured sleep period in microseconds.
+     */
+    int64_t sleepPeriod;
+
+    /**
+     * @brief The next time a valve needs to change state in microseconds since the epoch.
+     */
+    int64_t nextValveChange;
+
+    /**
+     * @brief Board-specific sensor configuration, see {@link AbstractFlowControlApp#getSensorConfig}.
+     */
+    uint32_t sensorConfig;
+
+    /**
+     * @brief The number of wakes left until the next upload, including the upload itself.
+     */
+    uint16_t wakesUntilUpload;
+    int8_t flowPin;
+
+    /**
+     * @brief The Q factor of the flow meter, see {@link MeterHandler#begin}.
+     */
+    float flowMeterQFactor;
+};
+
+RTC_DATA_ATTR
+RtcStored<SleepCycle> sampleBatchSleepCycle;
+
+RTC_DATA_ATTR
+SampleRing<PackedSample, SAMPLE_BATCH_CAPACITY> sampleBatchRing;
+
+/**
+ * @brief Buffers telemetry samples in RTC memory across short deep-sleep cycles, and publishes them in a single batch.
+ *
+ * On a timer wake between uploads, {@link #sampleBetweenUploads} takes a sample and puts the device back to sleep
+ * before the application starts, so WiFi is never brought up. Every N-th wake the device boots normally,
+ * and publishes the buffered samples as a <code>telemetry/batch</code> event. Any other wake boots normally, too.
+ * Short wakes never skip a valve change; the device boots normally when one is due.
+ *
+ * Flow pulses wake the device from sleep, so flow is never missed between samples: each sample records
+ * the volume counted while it was taken, and the device boots normally when there was any.
+ * The mode switch is not a wake source; a change is picked up at the next normal boot.
+ */
+class SampleBatchHandler
+    : public ProfiledTask {
+public:
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent)
+            : NamedConfigurationSection(parent, "batching") {
+        }
+
+        /**
+         * @brief Connect and publish every N-th wake only, 1 means every wake.
+         */
+        Property<int> uploadEvery { this, "uploadEvery", 1 };
+    };
+
+    typedef std::function<void(JsonObject&, uint32_t)> Sampler;
+
+    SampleBatchHandler(TaskContainer& tasks, EventHandler& events, const Config& config)
+        : ProfiledTask(tasks, "Sample batch")
+        , events(events)
+        , config(config) {
+    }
+
+    /**
+     * @brief Takes a sample and goes back to deep sleep if this is a short wake between uploads, returns otherwise.
+     *
+     * Must be called before the application starts, as nothing but the sampler is initialized.
+     * The sampler is passed the sensor configuration recorded before going to sleep.
+     */
+    static void sampleBetweenUploads(Sampler sampler) {
+        if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER) {
+            return;
+        }
+        SleepCycle cycle;
+        if (!sampleBatchSleepCycle.load(cycle) || cycle.wakesUntilUpload <= 1 || !sampleBatchRing.isValid()) {
+            return;
+        }
+        auto now = system_clock::now();
+        auto nextValveChange = fromMicros(cycle.nextValveChange);
+        if (now >= nextValveChange) {
+            return;
+        }
+
+        Serial.begin(115200);
+        gpio_num_t flowPin = static_cast<gpio_num_t>(cycle.flowPin);
+        pinMode(flowPin, INPUT);
+        // Count pulses while sampling; flow during sleep would have woken us up
+        FlowPulseCounter::begin(flowPin);
+        auto samplingStart = boot_clock::now();
+        DynamicJsonDocument doc(1024);
+        JsonObject json = doc.to<JsonObject>();
+        sampler(json, cycle.sensorConfig);
+        int16_t pulses = FlowPulseCounter::take();
+        MeterHandler::populateVolume(json, FlowPulseCounter::toVolume(pulses, cycle.flowMeterQFactor), boot_clock::now() - samplingStart);
+        sampleBatchRing.push(pack(json, now));
+        cycle.wakesUntilUpload--;
+        sampleBatchSleepCycle.store(cycle);
+        if (pulses > 0) {
+            Serial.printf("Counted %d flow pulses while sampling, starting up\n", pulses);
+            return;
+        }
+
+        auto sleepPeriod = std::min(microseconds { cycle.sleepPeriod }, duration_cast<microseconds>(nextValveChange - now));
+        Serial.printf("Buffered sample %d, %d wakes until upload, sleeping for %ld seconds\n",
+            sampleBatchRing.size(), cycle.wakesUntilUpload, (long) duration_cast<seconds>(sleepPeriod).count());
+        Serial.flush();
+
+        // Wake up immediately when flow starts
+        esp_sleep_enable_ext0_wakeup(flowPin, digitalRead(flowPin) == LOW);
+        esp_sleep_enable_timer_wakeup(sleepPeriod.count());
+        esp_deep_sleep_start();
+    }
+
+    /**
+     * @brief Records what the short wakes need to know; must be called right before going to deep sleep.
+     */
+    void prepareSleep(microseconds sleepPeriod, time_point<system_clock> nextValveChange, gpio_num_t flowPin, double flowMeterQFactor, uint32_t sensorConfig) {
+        if (!sampleBatchRing.isValid()) {
+            sampleBatchRing.reset();
+        }
+        SleepCycle cycle;
+        bool counting = sampleBatchSleepCycle.load(cycle) && cycle.wakesUntilUpload > 1;
+        cycle.sleepPeriod = sleepPeriod.count();
+        cycle.nextValveChange = duration_cast<microseconds>(nextValveChange.time_since_epoch()).count();
+        cycle.sensorConfig = sensorConfig;
+        cycle.flowPin = static_cast<int8_t>(flowPin);
+        cycle.flowMeterQFactor = static_cast<float>(flowMeterQFactor);
+        if (!counting) {
+            // We have just uploaded, start counting again
+            cycle.wakesUntilUpload = static_cast<uint16_t>(std::max(config.uploadEvery.get(), 1));
+        }
+        sampleBatchSleepCycle.store(cycle);
+    }
+
+protected:
+    const Schedule loop(const Timing& timing) override {
+        PROFILE_LOOP();
+        if (!sampleBatchRing.isValid() || sampleBatchRing.size() == 0) {
+            return profiledSleepIndefinitely();
+        }
+        if (WiFi.status() != WL_CONNECTED) {
+            return profiledSleepFor(seconds { 1 });
+        }
+        TRACE_BEGIN("mqtt/publish");
+        events.publishEvent("telemetry/batch", [&](JsonObject& json) {
+            JsonArray samplesJson = json.createNestedArray("samples");
+            for (size_t index = 0; index < sampleBatchRing.size(); index++) {
+                JsonObject sampleJson = samplesJson.createNestedObject();
+                unpack(sampleBatchRing.get(index), sampleJson);
+            }
+        });
+        TRACE_END("mqtt/publish");
+        Serial.printf("Published batch of %d samples\n", sampleBatchRing.size());
+        sampleBatchRing.reset();
+        sampleBatchSleepCycle.invalidate();
+        return profiledSleepIndefinitely();
+    }
+
+private:
+    static time_point<system_clock> fromMicros(int64_t micros) {
+        return time_point<system_clock>(duration_cast<system_clock::duration>(microseconds { micros }));
+    }
+
+    static PackedSample pack(const JsonObject& json, time_point<system_clock> time) {
+        PackedSample sample {};
+        sample.timestamp = duration_cast<seconds>(time.time_since_epoch()).count();
+        sample.volume = static_cast<uint32_t>(std::round((json["volume"] | 0.0) * 1000));
+        sample.flowRate = PackedSample::packHundredths(json["flowRate"] | NAN);
+        sample.temperature = PackedSample::packHundredths(json["temperature"] | NAN);
+        sample.humidity = PackedSample::packHundredths(json["humidity"] | NAN);
+        sample.soilTemperature = PackedSample::packHundredths(json["soilTemperature"] | NAN);
+        sample.soilMoisture = PackedSample::packHundredths(json["soilMoisture"] | NAN);
+        // Same layout as the valve telemetry: a single zone's state inline, multiple zones in an array
+        JsonArray zonesJson = json["zones"].as<JsonArray>();
+        if (zonesJson.isNull()) {
+            sample.zoneCount = 1;
+            sample.setZoneOpen(0, (json["valve"] | 0) > 0);
+        } else {
+            sample.zoneCount = static_cast<uint8_t>(std::min<size_t>(zonesJson.size(), 8));
+            for (size_t zone = 0; zone < sample.zoneCount; zone++) {
+                sample.setZoneOpen(zone, (zonesJson[zone]["valve"] | 0) > 0);
+            }
+        }
+        return sample;
+    }
+
+    static void unpack(const PackedSample& sample, JsonObject& json) {
+        json["timestamp"] = sample.timestamp;
+        json["volume"] = sample.volume / 1000.0;
+        if (sample.zoneCount <= 1) {
+            json["valve"] = unpackZone(sample, 0);
+        } else {
+            JsonArray zonesJson = json.createNestedArray("zones");
+            for (size_t zone = 0; zone < sample.zoneCount; zone++) {
+                zonesJson.createNestedObject()["valve"] = unpackZone(sample, zone);
+            }
+        }
+        unpackHundredths(json, "flowRate", sample.flowRate);
+        unpackHundredths(json, "temperature", sample.temperature);
+        unpackHundredths(json, "humidity", sample.humidity);
+        unpackHundredths(json, "soilTemperature", sample.soilTemperature);
+        unpackHundredths(json, "soilMoisture", sample.soilMoisture);
+    }
+
+    /**
+     * @brief The zone's state as reported in valve telemetry, 1 for open, -1 for closed.
+     */
+    static int unpackZone(const PackedSample& sample, size_t zone) {
+        return sample.isZoneOpen(zone) ? 1 : -1;
+    }
+
+    static void unpackHundredths(JsonObject& json, const char* key, int16_t value) {
+        if (value != PACKED_SAMPLE_MISSING) {
+            json[key] = PackedSample::unpackHundredths(value);
+        }
+    }
+
+    EventHandler& events;
+    const Config& config;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+/**
+ * @brief Robust reductions of bursts of noisy samples, e.g. from an ADC.
+ *
+ * All functions work in place and reorder the samples they are given, so they need no extra memory.
+ */
+class SampleFilter {
+public:
+    /**
+     * @return the median of the values, or NaN if there are none.
+     */
+    template <typename T>
+    static double median(T* values, size_t count) {
+        if (count == 0) {
+            return NAN;
+        }
+        T* middle = values + count / 2;
+        std::nth_element(values, middle, values + count);
+        if (count % 2 == 1) {
+            return *middle;
+        }
+        // The lower middle value is the largest of the ones before the middle
+        T lower = *std::max_element(values, middle);
+        return (static_cast<double>(lower) + *middle) / 2;
+    }
+
+    /**
+     * @return the mean of the values after dropping the given fraction of the lowest and highest values,
+     * or NaN if there are none. At least one value is always kept.
+     */
+    template <typename T>
+    static double trimmedMean(T* values, size_t count, double trimFraction) {
+        if (count == 0) {
+            return NAN;
+        }
+        std::sort(values, values + count);
+        size_t trim = std::min(static_cast<size_t>(count * trimFraction), (count - 1) / 2);
+        double sum = 0;
+        for (size_t i = trim; i < count - trim; i++) {
+            sum += values[i];
+        }
+        return sum / (count - 2 * trim);
+    }
+
+    /**
+     * @brief Takes the median of each window of consecutive samples, then the trimmed mean of the medians.
+     *
+     * The medians reject spikes, and the trimmed mean smooths out the remaining noise.
+     * The window should be odd, so that each median is one of the samples.
+     * Samples beyond the last full window are ignored; if there is no full window, it is the median of all samples.
+     */
+    template <typename T>
+    static double medianTrimmedMean(T* samples, size_t count, size_t window, double trimFraction) {
+        size_t windows = window == 0
+            ? 0
+            : count / window;
+        if (windows == 0) {
+            return median(samples, count);
+        }
+        // Each median is stored before its own window, so it never overwrites samples still to be used
+        for (size_t i = 0; i < windows; i++) {
+            samples[i] = static_cast<T>(median(samples + i * window, window));
+        }
+        return trimmedMean(samples, windows, trimFraction);
+    }
+};
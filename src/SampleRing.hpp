@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Marks a missing value in a {@link PackedSample}.
+ */
+const int16_t PACKED_SAMPLE_MISSING = INT16_MIN;
+
+/**
+ * @brief A telemetry sample packed into fixed-point fields, small enough to keep dozens in RTC memory.
+ *
+ * Temperatures, humidity and moisture are stored in hundredths, flow rate in hundredths of liters / min,
+ * and volume in milliliters. Missing values are marked with {@link PACKED_SAMPLE_MISSING}.
+ * Valve states are stored as a bitmask of the open zones, so up to 8 zones fit.
+ */
+struct PackedSample {
+    /**
+     * @brief Seconds since the epoch.
+     */
+    uint32_t timestamp;
+    uint32_t volume;
+    int16_t flowRate;
+    int16_t temperature;
+    int16_t humidity;
+    int16_t soilTemperature;
+    int16_t soilMoisture;
+
+    /**
+     * @brief Bit N is set if zone N was open.
+     */
+    uint8_t openZones;
+    uint8_t zoneCount;
+
+    bool isZoneOpen(size_t zone) const {
+        return zone < 8 && (openZones & (1 << zone)) != 0;
+    }
+
+    void setZoneOpen(size_t zone, bool open) {
+        if (zone >= 8) {
+            return;
+        }
+        if (open) {
+            openZones |= 1 << zone;
+        } else {
+            openZones &= ~(1 << zone);
+        }
+    }
+
+    /**
+     * @brief Packs the value in hundredths, saturating at the limits of the field.
+     */
+    static int16_t packHundredths(double value) {
+        if (std::isnan(value)) {
+            return PACKED_SAMPLE_MISSING;
+        }
+        double scaled = std::round(value * 100);
+        if (scaled <= PACKED_SAMPLE_MISSING) {
+            return PACKED_SAMPLE_MISSING + 1;
+        }
+        if (scaled > INT16_MAX) {
+            return INT16_MAX;
+        }
+        return static_cast<int16_t>(scaled);
+    }
+
+    static double unpackHundredths(int16_t value) {
+        return value == PACKED_SAMPLE_MISSING
+            ? NAN
+            : value / 100.0;
+    }
+};
+
+/**
+ * @brief A fixed-size ring of samples that overwrites the oldest sample when full.
+ *
+ * Kept as a plain aggregate so that it can be declared with <code>RTC_DATA_ATTR</code>;
+ * the marker tells a ring that survived deep sleep from uninitialized memory.
+ */
+template <typename T, size_t Capacity>
+struct SampleRing {
+    static const uint32_t VALID_MARKER = 0x534d504c;
+
+    uint32_t marker;
+    uint16_t head;
+    uint16_t count;
+    T samples[Capacity];
+
+    bool isValid() const {
+        return marker == VALID_MARKER && head < Capacity && count <= Capacity;
+    }
+
+    void reset() {
+        marker = VALID_MARKER;
+        head = 0;
+        count = 0;
+    }
+
+    void push(const T& sample) {
+        samples[head] = sample;
+        head = (head + 1) % Capacity;
+        if (count < Capacity) {
+            count++;
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool isFull() const {
+        return count == Capacity;
+    }
+
+    /**
+     * @brief The sample at the given index, the oldest being at index 0.
+     */
+    const T& get(size_t index) const {
+        return samples[(head + Capacity - count + index) % Capacity];
+    }
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+using std::chrono::milliseconds;
+using std::chrono::time_point;
+
+/**
+ * @brief Tracks the health of a sensor, and backs off exponentially while it keeps failing.
+ *
+ * After a number of consecutive failures the sensor is considered offline: it is only attempted again
+ * after a backoff that doubles with each failed attempt, up to a maximum, and each attempt should start
+ * with re-initializing the sensor, so that sensors that have been replaced or have recovered are picked up again.
+ */
+template <typename Clock>
+class SensorHealth {
+public:
+    enum class State {
+        HEALTHY = 0,
+        FAILING = 1,
+        OFFLINE = 2
+    };
+
+    /**
+     * @param failuresBeforeOffline the number of consecutive failures after which the sensor is considered offline.
+     * @param initialBackoff how long to wait before the first attempt after going offline.
+     * @param maxBackoff the longest to wait between attempts.
+     */
+    SensorHealth(int failuresBeforeOffline, milliseconds initialBackoff, milliseconds maxBackoff)
+        : failuresBeforeOffline(failuresBeforeOffline)
+        , initialBackoff(initialBackoff)
+        , maxBackoff(maxBackoff)
+        , backoff(initialBackoff) {
+    }
+
+    /**
+     * @brief Whether the sensor should be attempted now; while offline, only after the backoff.
+     */
+    bool isAttemptDue(time_point<Clock> now) const {
+        return state != State::OFFLINE || now >= nextAttempt;
+    }
+
+    /**
+     * @brief Whether the sensor should be re-initialized before the next attempt.
+     */
+    bool needsReinit() const {
+        return state == State::OFFLINE;
+    }
+
+    void recordSuccess() {
+        successCount++;
+        consecutiveFailures = 0;
+        backoff = initialBackoff;
+        state = State::HEALTHY;
+    }
+
+    void recordFailure(time_point<Clock> now) {
+        failureCount++;
+        consecutiveFailures++;
+        if (state == State::OFFLINE) {
+            backoff = std::min(backoff * 2, maxBackoff);
+            nextAttempt = now + backoff;
+        } else if (consecutiveFailures >= failuresBeforeOffline) {
+            markOffline(now);
+        } else {
+            state = State::FAILING;
+        }
+    }
+
+    /**
+     * @brief Takes the sensor offline right away, e.g. because it could not be initialized.
+     */
+    void markOffline(time_point<Clock> now) {
+        state = State::OFFLINE;
+        backoff = initialBackoff;
+        nextAttempt = now + backoff;
+    }
+
+    void recordReinit() {
+        reinitCount++;
+    }
+
+    State getState() const {
+        return state;
+    }
+
+    time_point<Clock> getNextAttempt() const {
+        return nextAttempt;
+    }
+
+    milliseconds getBackoff() const {
+        return backoff;
+    }
+
+    int getSuccessCount() const {
+        return successCount;
+    }
+
+    int getFailureCount() const {
+        return failureCount;
+    }
+
+    int getConsecutiveFailures() const {
+        return consecutiveFailures;
+    }
+
+    int getReinitCount() const {
+        return reinitCount;
+    }
+
+private:
+    const int failuresBeforeOffline;
+    const milliseconds initialBackoff;
+    const milliseconds maxBackoff;
+
+    State state = State::HEALTHY;
+    milliseconds backoff;
+    time_point<Clock> nextAttempt;
+    int successCount = 0;
+    int failureCount = 0;
+    int consecutiveFailures = 0;
+    int reinitCount = 0;
+};
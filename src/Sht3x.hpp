@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fetches the latest measurement in periodic mode.
+ */
+const uint16_t SHT3X_FETCH_DATA = 0xE000;
+
+/**
+ * @brief Stops periodic mode.
+ */
+const uint16_t SHT3X_BREAK = 0x3093;
+
+/**
+ * @brief Starts periodic mode with accelerated response time, measuring at 4 Hz.
+ */
+const uint16_t SHT3X_PERIODIC_ART = 0x2B32;
+
+const uint16_t SHT3X_HEATER_OFF = 0x3066;
+
+/**
+ * @brief The size of a measurement: temperature and humidity, each followed by its CRC.
+ */
+const size_t SHT3X_MEASUREMENT_SIZE = 6;
+
+/**
+ * @brief Commands and data formats of the Sensirion SHT3x humidity and temperature sensors.
+ */
+class Sht3x {
+public:
+    /**
+     * @brief The command to start periodic mode with high repeatability at the given measurements per second.
+     *
+     * @return false if the sensor does not support the rate; it supports 0.5, 1, 2, 4 and 10.
+     */
+    static bool getPeriodicCommand(double rate, uint16_t& command) {
+        if (rate == 0.5) {
+            command = 0x2032;
+        } else if (rate == 1) {
+            command = 0x2130;
+        } else if (rate == 2) {
+            command = 0x2236;
+        } else if (rate == 4) {
+            command = 0x2334;
+        } else if (rate == 10) {
+            command = 0x2737;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief CRC-8 with polynomial 0x31 and initial value 0xFF, as used by the sensor for every 16-bit word.
+     */
+    static uint8_t crc8(const uint8_t* data, size_t length) {
+        uint8_t crc = 0xFF;
+        for (size_t i = 0; i < length; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x80)
+                    ? (crc << 1) ^ 0x31
+                    : crc << 1;
+            }
+        }
+        return crc;
+    }
+
+    /**
+     * @brief Converts a measurement read from the sensor to °C and %RH.
+     *
+     * @return false if either word fails its CRC check.
+     */
+    static bool parseMeasurement(const uint8_t* data, double& temperature, double& humidity) {
+        if (crc8(data, 2) != data[2] || crc8(data + 3, 2) != data[5]) {
+            return false;
+        }
+        uint16_t rawTemperature = (data[0] << 8) | data[1];
+        uint16_t rawHumidity = (data[3] << 8) | data[4];
+        temperature = -45 + 175 * (rawTemperature / 65535.0);
+        humidity = 100 * (rawHumidity / 65535.0);
+        return true;
+    }
+};
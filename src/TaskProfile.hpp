@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+using std::chrono::microseconds;
+
+/**
+ * @brief The number of buckets in the loop duration histogram.
+ *
+ * Bucket N counts loops that took less than 10^(N+1) µs, the last bucket counts everything longer.
+ */
+const size_t TASK_PROFILE_BUCKETS = 6;
+
+/**
+ * @brief Statistics about the loops of a task: how often it wakes, how long its loops take, and how long it asks to sleep.
+ */
+class TaskProfile {
+public:
+    TaskProfile(const char* name)
+        : name(name) {
+    }
+
+    void recordLoop(microseconds duration) {
+        wakes++;
+        if (duration > maxLoop) {
+            maxLoop = duration;
+        }
+        totalLoop += duration;
+        histogram[getBucket(duration)]++;
+    }
+
+    /**
+     * @brief Records the sleep requested at the end of a loop; a negative duration means sleeping indefinitely.
+     */
+    void recordSleep(microseconds sleep) {
+        lastSleep = sleep;
+    }
+
+    static size_t getBucket(microseconds duration) {
+        size_t bucket = 0;
+        for (int64_t limit = 10; bucket < TASK_PROFILE_BUCKETS - 1 && duration.count() >= limit; limit *= 10) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    const char* getName() const {
+        return name;
+    }
+
+    uint32_t getWakes() const {
+        return wakes;
+    }
+
+    microseconds getMaxLoop() const {
+        return maxLoop;
+    }
+
+    microseconds getTotalLoop() const {
+        return totalLoop;
+    }
+
+    microseconds getLastSleep() const {
+        return lastSleep;
+    }
+
+    uint32_t getHistogram(size_t bucket) const {
+        return histogram[bucket];
+    }
+
+private:
+    const char* name;
+    uint32_t wakes = 0;
+    microseconds maxLoop = microseconds::zero();
+    microseconds totalLoop = microseconds::zero();
+    microseconds lastSleep = microseconds::zero();
+    uint32_t histogram[TASK_PROFILE_BUCKETS] = {};
+};
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "JournalStorage.hpp"
+
+/**
+ * @brief A record read back from the {@link TelemetryJournal}.
+ */
+struct JournalRecord {
+    /**
+     * @brief Seconds since the epoch.
+     */
+    uint32_t timestamp;
+    std::vector<uint8_t> data;
+
+    /**
+     * @brief Where the record is stored, used to mark it consumed.
+     */
+    size_t offset;
+};
+
+/**
+ * @brief An append-only ring journal of timestamped records in sector-erasable storage.
+ *
+ * Sectors are filled one after the other, and a sector is only erased when the journal wraps around to it,
+ * so every sector wears evenly. When the journal is full, the oldest sector is dropped, pending or not.
+ *
+ * Each sector starts with a marker and an ever increasing sequence number, used to find the newest
+ * sector after a restart. Records are written header first, and committed by clearing bits in their
+ * state byte after the payload has been written; consumed records are marked by clearing the remaining bits.
+ * Neither needs an erase, and a record torn by a reset is skipped.
+ */
+class TelemetryJournal {
+public:
+    TelemetryJournal(JournalStorage& storage)
+        : storage(storage) {
+    }
+
+    /**
+     * @brief Scans the storage to continue where the journal left off, formatting it if necessary.
+     */
+    void begin() {
+        sectorSize = storage.getSectorSize();
+        sectorCount = storage.getSectorCount();
+        pending = 0;
+        dropped = 0;
+
+        bool found = false;
+        uint32_t newestSequence = 0;
+        for (size_t sector = 0; sector < sectorCount; sector++) {
+            SectorHeader header;
+            if (readSectorHeader(sector, header) && (!found || header.sequence > newestSequence)) {
+                found = true;
+                newestSequence = header.sequence;
+                writeSector = sector;
+            }
+        }
+        if (!found) {
+            nextSequence = 1;
+            startSector(0);
+            readSector = writeSector;
+            readOffset = writeOffset;
+            return;
+        }
+        nextSequence = newestSequence + 1;
+
+        // The oldest sector is the first formatted one after the newest
+        size_t oldestSector = writeSector;
+        for (size_t i = 1; i < sectorCount; i++) {
+            size_t sector = (writeSector + i) % sectorCount;
+            SectorHeader header;
+            if (readSectorHeader(sector, header)) {
+                oldestSector = sector;
+                break;
+            }
+        }
+
+        bool readPositionFound = false;
+        for (size_t sector = oldestSector;; sector = (sector + 1) % sectorCount) {
+            size_t offset = SECTOR_HEADER_SIZE;
+            RecordHeader header;
+            while (readRecordHeader(sector, offset, header)) {
+                if (header.state == STATE_COMMITTED && isIntact(sector * sectorSize + offset, header)) {
+                    if (!readPositionFound) {
+                        readPositionFound = true;
+                        readSector = sector;
+                        readOffset = offset;
+                    }
+                    pending++;
+                }
+                offset += getRecordSize(header.length);
+            }
+            if (sector == writeSector) {
+                // Do not write over anything that is not erased, e.g. a record with a corrupted length
+                writeOffset = isErased(sector, offset)
+                    ? offset
+                    : sectorSize;
+                break;
+            }
+        }
+        if (!readPositionFound) {
+            readSector = writeSector;
+            readOffset = writeOffset;
+        }
+    }
+
+    /**
+     * @return false if the record is too large, or the storage failed.
+     */
+    bool append(uint32_t timestamp, const void* data, size_t length) {
+        if (length > getMaxRecordSize()) {
+            return false;
+        }
+        if (writeOffset + getRecordSize(length) > sectorSize) {
+            if (!advanceWriteSector()) {
+                return false;
+            }
+        }
+        size_t offset = writeSector * sectorSize + writeOffset;
+        RecordHeader header {
+            static_cast<uint16_t>(length),
+            STATE_ERASED,
+            calculateChecksum(timestamp, data, length),
+            timestamp
+        };
+        writeOffset += getRecordSize(length);
+        if (!storage.write(offset, &header, sizeof(header))
+            || !storage.write(offset + sizeof(header), data, length)
+            || !writeState(offset, STATE_COMMITTED)) {
+            return false;
+        }
+        pending++;
+        return true;
+    }
+
+    /**
+     * @brief Reads up to the given number of the oldest pending records, without consuming them.
+     */
+    size_t readBatch(size_t maxRecords, std::vector<JournalRecord>& records) {
+        records.clear();
+        size_t sector = readSector;
+        size_t offset = readOffset;
+        while (records.size() < maxRecords) {
+            if (sector == writeSector && offset >= writeOffset) {
+                break;
+            }
+            RecordHeader header;
+            if (!readRecordHeader(sector, offset, header)) {
+                if (sector == writeSector) {
+                    break;
+                }
+                sector = (sector + 1) % sectorCount;
+                offset = SECTOR_HEADER_SIZE;
+                continue;
+            }
+            size_t absoluteOffset = sector * sectorSize + offset;
+            offset += getRecordSize(header.length);
+            if (header.state != STATE_COMMITTED) {
+                continue;
+            }
+            JournalRecord record { header.timestamp, std::vector<uint8_t>(header.length), absoluteOffset };
+            if (!storage.read(absoluteOffset + sizeof(header), record.data.data(), header.length)
+                || calculateChecksum(header.timestamp, record.data.data(), header.length) != header.checksum) {
+                continue;
+            }
+            records.push_back(std::move(record));
+        }
+        return records.size();
+    }
+
+    /**
+     * @brief Marks the records returned by {@link #readBatch} as consumed.
+     */
+    void consume(const std::vector<JournalRecord>& records) {
+        for (auto& record : records) {
+            writeState(record.offset, STATE_CONSUMED);
+            if (pending > 0) {
+                pending--;
+            }
+            readSector = record.offset / sectorSize;
+            readOffset = record.offset % sectorSize + getRecordSize(record.data.size());
+        }
+    }
+
+    size_t getPendingCount() const {
+        return pending;
+    }
+
+    /**
+     * @brief The number of pending records dropped because the journal was full.
+     */
+    size_t getDroppedCount() const {
+        return dropped;
+    }
+
+    size_t getMaxRecordSize() const {
+        return sectorSize - SECTOR_HEADER_SIZE - sizeof(RecordHeader);
+    }
+
+private:
+    struct SectorHeader {
+        uint32_t marker;
+        uint32_t sequence;
+    };
+
+    struct RecordHeader {
+        uint16_t length;
+        uint8_t state;
+        uint8_t checksum;
+        uint32_t timestamp;
+    };
+
+    static const uint32_t SECTOR_MARKER = 0x4a524e4c;
+    static const size_t SECTOR_HEADER_SIZE = sizeof(SectorHeader);
+    static const uint16_t LENGTH_ERASED = 0xFFFF;
+    static const uint8_t STATE_ERASED = 0xFF;
+    static const uint8_t STATE_COMMITTED = 0xF0;
+    static const uint8_t STATE_CONSUMED = 0x00;
+
+    /**
+     * @brief The space a record takes up, keeping records word-aligned.
+     */
+    static size_t getRecordSize(size_t length) {
+        return sizeof(RecordHeader) + ((length + 3) & ~(size_t) 3);
+    }
+
+    static uint8_t calculateChecksum(uint32_t timestamp, const void* data, size_t length) {
+        uint32_t hash = 2166136261u;
+        auto hashBytes = [&hash](const uint8_t* bytes, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                hash = (hash ^ bytes[i]) * 16777619u;
+            }
+        };
+        hashBytes(reinterpret_cast<const uint8_t*>(&timestamp), sizeof(timestamp));
+        hashBytes(static_cast<const uint8_t*>(data), length);
+        return static_cast<uint8_t>(hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24));
+    }
+
+    bool readSectorHeader(size_t sector, SectorHeader& header) {
+        return storage.read(sector * sectorSize, &header, sizeof(header))
+            && header.marker == SECTOR_MARKER;
+    }
+
+    /**
+     * @return false at the end of the records in the sector.
+     */
+    bool readRecordHeader(size_t sector, size_t offset, RecordHeader& header) {
+        if (offset + sizeof(header) > sectorSize
+            || !storage.read(sector * sectorSize + offset, &header, sizeof(header))
+            || header.length == LENGTH_ERASED) {
+            return false;
+        }
+        // A corrupted length ends the sector
+        return offset + getRecordSize(header.length) <= sectorSize;
+    }
+
+    bool isErased(size_t sector, size_t offset) {
+        uint16_t length;
+        return offset + sizeof(RecordHeader) > sectorSize
+            || (storage.read(sector * sectorSize + offset, &length, sizeof(length)) && length == LENGTH_ERASED);
+    }
+
+    bool isIntact(size_t offset, const RecordHeader& header) {
+        std::vector<uint8_t> data(header.length);
+        return storage.read(offset + sizeof(header), data.data(), header.length)
+            && calculateChecksum(header.timestamp, data.data(), header.length) == header.checksum;
+    }
+
+    bool writeState(size_t offset, uint8_t state) {
+        return storage.write(offset + offsetof(RecordHeader, state), &state, sizeof(state));
+    }
+
+    bool advanceWriteSector() {
+        size_t next = (writeSector + 1) % sectorCount;
+        if (next == readSector && pending > 0) {
+            dropSector(next);
+        }
+        if (!startSector(next)) {
+            return false;
+        }
+        if (pending == 0) {
+            readSector = writeSector;
+            readOffset = writeOffset;
+        }
+        return true;
+    }
+
+    void dropSector(size_t sector) {
+        size_t offset = SECTOR_HEADER_SIZE;
+        RecordHeader header;
+        while (readRecordHeader(sector, offset, header)) {
+            if (header.state == STATE_COMMITTED
+                && (sector != readSector || offset >= readOffset)
+                && isIntact(sector * sectorSize + offset, header)
+                && pending > 0) {
+                pending--;
+                dropped++;
+            }
+            offset += getRecordSize(header.length);
+        }
+        readSector = (sector + 1) % sectorCount;
+        readOffset = SECTOR_HEADER_SIZE;
+    }
+
+    bool startSector(size_t sector) {
+        SectorHeader header { SECTOR_MARKER, nextSequence++ };
+        writeSector = sector;
+        writeOffset = SECTOR_HEADER_SIZE;
+        return storage.erase(sector)
+            && storage.write(sector * sectorSize, &header, sizeof(header));
+    }
+
+    JournalStorage& storage;
+    size_t sectorSize = 0;
+    size_t sectorCount = 0;
+
+    uint32_t nextSequence = 1;
+    size_t writeSector = 0;
+    size_t writeOffset = 0;
+    size_t readSector = 0;
+    size_t readOffset = 0;
+    size_t pending = 0;
+    size_t dropped = 0;
+};
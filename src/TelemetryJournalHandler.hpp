@@ -0,0 +1,184 @@
+#pragma once
+
+#include <list>
+
+#include <WiFi.h>
+
+#include <Task.hpp>
+#include <Telemetry.hpp>
+
+#include "PartitionJournalStorage.hpp"
+#include "ProfiledTask.hpp"
+#include "TelemetryJournal.hpp"
+#include "TelemetrySnapshotProvider.hpp"
+#include "Tracer.hpp"
+
+using namespace std::chrono;
+using namespace farmhub::client;
+
+/**
+ * @brief The maximum size of a serialized telemetry record.
+ */
+const size_t JOURNAL_RECORD_CAPACITY = 1024;
+
+/**
+ * @brief The size of the document a batch of replayed records is published in.
+ */
+const size_t JOURNAL_BATCH_CAPACITY = 8192;
+
+static_assert(JOURNAL_BATCH_CAPACITY >= 2 * JOURNAL_RECORD_CAPACITY, "A batch must fit at least one record");
+
+/**
+ * @brief How often to publish batches while replaying the journal.
+ */
+const seconds JOURNAL_REPLAY_INTERVAL { 1 };
+
+/**
+ * @brief Records telemetry into a journal in flash while the device is offline,
+ * and replays it in batches once connectivity returns.
+ *
+ * Each record holds a snapshot of the telemetry of all registered providers as JSON, timestamped with the time
+ * of collection. Snapshots leave the live telemetry alone, so recording never takes data
+ * away from the telemetry publisher.
+ * Replayed records are published to <code>telemetry/journal</code> in batches limited by both the configured
+ * number of records and the size of the batch document. Records are only consumed once the batch has been
+ * published, so a batch that fails because MQTT is not connected is kept, and recording continues meanwhile.
+ */
+class TelemetryJournalHandler
+    : public ProfiledTask {
+public:
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent)
+            : NamedConfigurationSection(parent, "journal") {
+        }
+
+        Property<bool> enabled { this, "enabled", false };
+
+        /**
+         * @brief How often to record telemetry while offline.
+         */
+        Property<seconds> interval { this, "interval", minutes { 1 } };
+
+        /**
+         * @brief The maximum number of records to publish in a single batch; batches are also limited by {@link JOURNAL_BATCH_CAPACITY}.
+         */
+        Property<int> batchSize { this, "batchSize", 10 };
+    };
+
+    TelemetryJournalHandler(TaskContainer& tasks, MqttHandler& mqtt, const Config& config)
+        : ProfiledTask(tasks, "Telemetry journal")
+        , mqtt(mqtt)
+        , config(config) {
+    }
+
+    /**
+     * @brief Registers a provider whose telemetry is recorded while offline.
+     */
+    void registerProvider(TelemetrySnapshotProvider& provider) {
+        providers.push_back(&provider);
+    }
+
+    void begin() {
+        if (!config.enabled.get()) {
+            return;
+        }
+        if (!storage.begin("spiffs")) {
+            return;
+        }
+        journal.begin();
+        Serial.printf("Telemetry journal has %d pending records\n", journal.getPendingCount());
+        enabled = true;
+    }
+
+protected:
+    const Schedule loop(const Timing& timing) override {
+        PROFILE_LOOP();
+        if (!enabled) {
+            return profiledSleepIndefinitely();
+        }
+        if (WiFi.status() == WL_CONNECTED) {
+            if (journal.getPendingCount() == 0) {
+                return profiledSleepFor(config.interval.get());
+            }
+            if (replay()) {
+                // Keep going until the backlog is cleared
+                return profiledSleepFor(JOURNAL_REPLAY_INTERVAL);
+            }
+            // MQTT is not connected yet, keep recording
+        }
+        record();
+        return profiledSleepFor(config.interval.get());
+    }
+
+private:
+    void record() {
+        TRACE_SCOPE("journal/record");
+        DynamicJsonDocument doc(JOURNAL_RECORD_CAPACITY);
+        JsonObject json = doc.to<JsonObject>();
+        for (auto provider : providers) {
+            provider->populateSnapshot(json);
+        }
+        // Leave room for the terminator written by serializeJson()
+        if (measureJson(doc) >= sizeof(buffer)) {
+            Serial.println("Telemetry too large to record in journal");
+            return;
+        }
+        size_t length = serializeJson(doc, buffer, sizeof(buffer));
+        auto timestamp = duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+        if (!journal.append(timestamp, buffer, length)) {
+            Serial.printf("Failed to record %d bytes of telemetry in journal\n", length);
+        }
+    }
+
+    /**
+     * @brief Publishes the next batch of records, and consumes them if it was published.
+     *
+     * @return false if the batch could not be published.
+     */
+    bool replay() {
+        if (journal.readBatch(config.batchSize.get(), records) == 0) {
+            return true;
+        }
+        TRACE_SCOPE("mqtt/publish");
+        DynamicJsonDocument batch(JOURNAL_BATCH_CAPACITY);
+        JsonArray recordsJson = batch.createNestedArray("records");
+        size_t batched = 0;
+        for (auto& record : records) {
+            DynamicJsonDocument telemetry(JOURNAL_RECORD_CAPACITY);
+            if (deserializeJson(telemetry, record.data.data(), record.data.size())) {
+                // Records that cannot be decoded are consumed with the batch, and dropped
+                batched++;
+                continue;
+            }
+            // Copying the record takes about as much memory as the record itself, plus the record object
+            size_t needed = telemetry.memoryUsage() + JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(2);
+            if (batched > 0 && batch.memoryUsage() + needed > batch.capacity()) {
+                break;
+            }
+            JsonObject recordJson = recordsJson.createNestedObject();
+            recordJson["timestamp"] = record.timestamp;
+            recordJson["telemetry"] = telemetry.as<JsonObject>();
+            batched++;
+        }
+        records.resize(batched);
+        if (!mqtt.publish("telemetry/journal", batch)) {
+            return false;
+        }
+        journal.consume(records);
+        Serial.printf("Replayed %d records from telemetry journal, %d pending\n",
+            records.size(), journal.getPendingCount());
+        return true;
+    }
+
+    MqttHandler& mqtt;
+    const Config& config;
+    bool enabled = false;
+
+    std::list<TelemetrySnapshotProvider*> providers;
+    PartitionJournalStorage storage;
+    TelemetryJournal journal { storage };
+    std::vector<JournalRecord> records;
+    char buffer[JOURNAL_RECORD_CAPACITY];
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <ArduinoJson.h>
+
+/**
+ * @brief Provides a snapshot of telemetry without affecting what is reported to the telemetry publisher,
+ * e.g. without resetting the volume or the aggregates collected since the last publication.
+ */
+class TelemetrySnapshotProvider {
+public:
+    virtual void populateSnapshot(JsonObject& json) = 0;
+};
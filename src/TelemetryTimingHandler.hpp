@@ -0,0 +1,122 @@
+#pragma once
+
+#include <list>
+
+#include <Events.hpp>
+#include <Task.hpp>
+#include <Telemetry.hpp>
+
+#include "LatencyStats.hpp"
+#include "ProfiledTask.hpp"
+#include "Tracer.hpp"
+
+using namespace std::chrono;
+using namespace farmhub::client;
+
+/**
+ * @brief Measures how long each telemetry provider takes to populate telemetry, and warns about the ones over budget.
+ *
+ * Providers are registered with the publisher via {@link #wrap}. Each provider reports its timing in microseconds
+ * under <code>telemetryLatency.&lt;name&gt;</code>, and a <code>telemetry/slow</code> event is published
+ * whenever a provider takes longer than the budget.
+ */
+class TelemetryTimingHandler
+    : public ProfiledTask {
+public:
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent)
+            : NamedConfigurationSection(parent, "telemetryTiming") {
+        }
+
+        /**
+         * @brief How long a single provider may take to populate telemetry, zero to disable warnings.
+         */
+        Property<milliseconds> budget { this, "budget", milliseconds { 100 } };
+    };
+
+    TelemetryTimingHandler(TaskContainer& tasks, EventHandler& events, const Config& config)
+        : ProfiledTask(tasks, "Telemetry timing")
+        , events(events)
+        , config(config) {
+    }
+
+    /**
+     * @brief Wraps the provider so that its calls are timed; register the returned provider instead.
+     */
+    TelemetryProvider& wrap(const char* name, TelemetryProvider& provider) {
+        providers.emplace_back(*this, name, provider);
+        return providers.back();
+    }
+
+protected:
+    const Schedule loop(const Timing& timing) override {
+        PROFILE_LOOP();
+        for (auto& slow : slowProviders) {
+            TRACE_SCOPE("mqtt/publish");
+            events.publishEvent("telemetry/slow", [&](JsonObject& json) {
+                json["provider"] = slow.name;
+                json["duration"] = duration_cast<milliseconds>(slow.duration).count();
+                json["budget"] = config.budget.get().count();
+            });
+        }
+        slowProviders.clear();
+        return profiledSleepFor(seconds { 1 });
+    }
+
+private:
+    class TimedTelemetryProvider
+        : public TelemetryProvider {
+    public:
+        TimedTelemetryProvider(TelemetryTimingHandler& handler, const char* name, TelemetryProvider& provider)
+            : handler(handler)
+            , name(name)
+            , provider(provider) {
+        }
+
+        void populateTelemetry(JsonObject& json) override {
+            auto start = boot_clock::now();
+            provider.populateTelemetry(json);
+            auto elapsed = duration_cast<microseconds>(boot_clock::now() - start);
+            stats.record(elapsed);
+            handler.checkBudget(name, elapsed);
+
+            JsonObject latenciesJson = json.containsKey("telemetryLatency")
+                ? json["telemetryLatency"].as<JsonObject>()
+                : json.createNestedObject("telemetryLatency");
+            JsonObject latencyJson = latenciesJson.createNestedObject(name);
+            latencyJson["last"] = stats.getLast().count();
+            latencyJson["max"] = stats.getMax().count();
+            latencyJson["average"] = stats.getAverage().count();
+        }
+
+    private:
+        TelemetryTimingHandler& handler;
+        const char* name;
+        TelemetryProvider& provider;
+        LatencyStats stats;
+    };
+
+    struct SlowProvider {
+        const char* name;
+        microseconds duration;
+    };
+
+    /**
+     * @brief Queues a warning if the provider went over budget; the event is published later, not while telemetry is being populated.
+     */
+    void checkBudget(const char* name, microseconds elapsed) {
+        microseconds budget = config.budget.get();
+        if (budget > microseconds::zero() && elapsed > budget) {
+            Serial.printf("Telemetry provider %s took %ld ms, over the budget of %ld ms\n",
+                name, (long) duration_cast<milliseconds>(elapsed).count(), (long) duration_cast<milliseconds>(budget).count());
+            slowProviders.push_back({ name, elapsed });
+        }
+    }
+
+    EventHandler& events;
+    const Config& config;
+    std::list<TimedTelemetryProvider> providers;
+    std::list<SlowProvider> slowProviders;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief The phases of trace events, using the letters of the Chrome trace event format.
+ */
+enum class TracePhase : char {
+    BEGIN = 'B',
+    END = 'E',
+    INSTANT = 'i'
+};
+
+/**
+ * @brief A span boundary or instant event recorded by the tracer.
+ */
+struct TraceEvent {
+    /**
+     * @brief Microseconds since boot.
+     */
+    int64_t timestamp;
+
+    /**
+     * @brief Must point to a string that lives forever, typically a literal.
+     */
+    const char* name;
+
+    /**
+     * @brief Identifies the FreeRTOS task that recorded the event.
+     */
+    uint32_t thread;
+    TracePhase phase;
+
+    /**
+     * @brief Formats the event as a line of the serial dump, e.g. <code>trace B 1234567 3ffb8c2c valve/evaluate</code>.
+     *
+     * @return the length of the formatted line, as with snprintf().
+     */
+    static int format(const TraceEvent& event, char* buffer, size_t size) {
+        return snprintf(buffer, size, "trace %c %" PRId64 " %08" PRIx32 " %s",
+            static_cast<char>(event.phase), event.timestamp, event.thread, event.name);
+    }
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#ifdef TRACE
+
+#include <atomic>
+#include <mutex>
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <ArduinoJson.h>
+
+#include "SampleRing.hpp"
+#include "TraceEvent.hpp"
+
+/**
+ * @brief The number of events kept in RAM; the oldest events are overwritten.
+ */
+const size_t TRACE_BUFFER_CAPACITY = 256;
+
+/**
+ * @brief The number of events returned by a single <code>trace</code> command, so that the response fits in a message.
+ */
+const size_t TRACE_RESPONSE_LIMIT = 32;
+
+/**
+ * @brief Records spans and instant events into a fixed-size ring buffer in RAM.
+ *
+ * Only available when built with <code>TRACE</code>; otherwise the tracing macros compile out completely.
+ * The buffer can be dumped over serial or fetched via the <code>trace</code> command,
+ * and converted to Chrome trace JSON for Perfetto with <code>trace-to-chrome.py</code>.
+ */
+class Tracer {
+public:
+    static void record(TracePhase phase, const char* name) {
+        if (paused) {
+            return;
+        }
+        TraceEvent event {
+            esp_timer_get_time(),
+            name,
+            static_cast<uint32_t>(reinterpret_cast<uintptr_t>(xTaskGetCurrentTaskHandle())),
+            phase
+        };
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!buffer.isValid()) {
+            buffer.reset();
+        }
+        buffer.push(event);
+    }
+
+    /**
+     * @brief Prints the buffer over serial, oldest event first; events are not recorded in the meantime.
+     */
+    static void dump(Print& out) {
+        paused = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        char line[96];
+        for (size_t index = 0; buffer.isValid() && index < buffer.size(); index++) {
+            TraceEvent::format(buffer.get(index), line, sizeof(line));
+            out.println(line);
+        }
+        paused = false;
+    }
+
+    /**
+     * @brief Adds a page of events to the JSON as <code>[timestamp, phase, thread, name]</code> arrays, oldest event first.
+     */
+    static void populate(JsonObject& json, size_t offset, size_t limit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t size = buffer.isValid() ? buffer.size() : 0;
+        json["total"] = size;
+        JsonArray eventsJson = json.createNestedArray("events");
+        for (size_t index = offset; index < size && index < offset + limit; index++) {
+            auto& event = buffer.get(index);
+            JsonArray eventJson = eventsJson.createNestedArray();
+            eventJson.add(event.timestamp);
+            eventJson.add(String(static_cast<char>(event.phase)));
+            eventJson.add(event.thread);
+            eventJson.add(event.name);
+        }
+    }
+
+    static void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.reset();
+    }
+
+private:
+    static std::mutex mutex;
+    static std::atomic<bool> paused;
+    static SampleRing<TraceEvent, TRACE_BUFFER_CAPACITY> buffer;
+};
+
+std::mutex Tracer::mutex;
+std::atomic<bool> Tracer::paused { false };
+SampleRing<TraceEvent, TRACE_BUFFER_CAPACITY> Tracer::buffer;
+
+/**
+ * @brief Records a span for as long as it is in scope.
+ */
+class TraceScope {
+public:
+    TraceScope(const char* name)
+        : name(name) {
+        Tracer::record(TracePhase::BEGIN, name);
+    }
+
+    ~TraceScope() {
+        Tracer::record(TracePhase::END, name);
+    }
+
+private:
+    const char* name;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_BEGIN(name) Tracer::record(TracePhase::BEGIN, name)
+#define TRACE_END(name) Tracer::record(TracePhase::END, name)
+#define TRACE_INSTANT(name) Tracer::record(TracePhase::INSTANT, name)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_INSTANT(name)
+#define TRACE_SCOPE(name)
+
+#endif
@@ -1,34 +1,170 @@
 #pragma once
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
 #include <Events.hpp>
 #include <Task.hpp>
 #include <Telemetry.hpp>
 
+#include "ActuationScheduler.hpp"
+#include "CommandMailbox.hpp"
+#include "CommandTrace.hpp"
+#include "FlowVerifier.hpp"
+#include "LatenessHistogram.hpp"
+#include "MeterHandler.hpp"
+#include "ProfiledTask.hpp"
+#include "RtcStored.hpp"
+#include "TelemetrySnapshotProvider.hpp"
+#include "Tracer.hpp"
 #include "ValveScheduler.hpp"
+#include "ZoneProgramPlanner.hpp"
 
 using namespace std::chrono;
 using namespace farmhub::client;
 
+/**
+ * @brief The maximum number of zones (valves) a single board can handle.
+ */
+const size_t VALVE_MAX_ZONES = 8;
+
+/**
+ * @brief The longest the valve actuation task sleeps without re-evaluating, in case the system clock is adjusted.
+ */
+const seconds VALVE_MAX_EVALUATION_INTERVAL { 60 };
+
+/**
+ * @brief How long after its planned end a drive pulse is waited for before the zone's state is reported without it.
+ */
+const milliseconds VALVE_PULSE_COMPLETION_TIMEOUT { 1000 };
+
+/**
+ * @brief How often events queued by the valve actuation task are published while the valves are busy.
+ */
+const milliseconds VALVE_EVENT_PUBLISH_INTERVAL { 500 };
+
+/**
+ * @brief How often the event queue is checked while the valves are idle, bounding the delay of the first event of a command.
+ */
+const seconds VALVE_EVENT_IDLE_PUBLISH_INTERVAL { 5 };
+
+/**
+ * @brief What initiated a manual override of a zone.
+ */
+enum class OverrideSource : int8_t {
+    NONE = 0,
+    MQTT = 1,
+    MODE_SWITCH = 2
+};
+
+struct StoredOverride {
+    /**
+     * @brief The end of the override in microseconds since the epoch.
+     */
+    int64_t end;
+    OverrideSource source;
+};
+
+RTC_DATA_ATTR
+int8_t valveHandlerStoredState[VALVE_MAX_ZONES];
+
+RTC_DATA_ATTR
+RtcStored<StoredOverride> valveHandlerStoredOverrides[VALVE_MAX_ZONES];
+
+/**
+ * @brief The time of the last evaluation in microseconds since the epoch, so that edges passed during deep sleep are measured, too.
+ */
 RTC_DATA_ATTR
-int8_t valveHandlerStoredState;
+RtcStored<int64_t> valveHandlerLastEvaluation;
 
+/**
+ * @brief How late scheduled transitions have completed, kept across deep sleep so that percentiles cover more than a single wake.
+ */
+RTC_DATA_ATTR
+RtcStored<LatenessHistogram> valveHandlerEdgeLateness;
+
+/**
+ * @brief Drives a physical valve.
+ *
+ * Implementations may return from {@link #open} and {@link #close} before the valve has finished moving,
+ * but must report the end of every drive pulse via {@link #pulseCompleted}.
+ * Only called from the valve actuation task.
+ */
 class ValveController {
 public:
+    /**
+     * @brief Sets the callback to notify when a drive pulse towards the open or closed state has finished.
+     *
+     * The callback may be called from any task, but not from an ISR.
+     */
+    void onPulseCompleted(std::function<void(bool open)> callback) {
+        pulseCompletedCallback = callback;
+    }
+
     virtual void open() = 0;
     virtual void close() = 0;
     virtual void reset() = 0;
+
+    /**
+     * @brief Re-issues the drive pulse towards the open or closed state, with the peak phase stretched by the given factor.
+     */
+    virtual void retry(bool open, double pulseScale) = 0;
+
+    /**
+     * @brief How long the valve draws peak current when switching to the open or closed state.
+     */
+    virtual milliseconds getPeakDuration(bool open) = 0;
+
+    /**
+     * @brief The current drawn during the peak phase, in mA.
+     */
+    virtual uint32_t getPeakCurrent() = 0;
+
+protected:
+    void pulseCompleted(bool open) {
+        if (pulseCompletedCallback) {
+            pulseCompletedCallback(open);
+        }
+    }
+
+private:
+    std::function<void(bool open)> pulseCompletedCallback;
 };
 
 /**
- * @brief Handles the valve on an abstract level.
+ * @brief Handles the valves of all zones on an abstract level.
+ *
+ * Each zone is driven by its own {@link ValveController}, and has its own schedules and override state.
+ * Zone programs are fitted into the available windows and the hydraulic capacity via a {@link ZoneProgramPlanner}.
+ * Per-zone schedules and overrides bypass the planner, and are not counted against the hydraulic capacity.
+ * State changes are actuated via an {@link ActuationScheduler} that staggers the peak-drive phases
+ * of the valves to stay within the configured concurrency and current budget.
+ * Optionally verifies via the flow meter that the valves have actually moved, and retries otherwise;
+ * retried drive pulses are staggered by the same scheduler.
  *
- * Allows opening and closing via {@link ValveHandler#setState}.
- * Handles remote MQTT commands to open and close the valve.
- * Reports the valve's state via MQTT.
+ * The valves are driven from a dedicated task that sleeps until the next schedule edge, override end
+ * or pending actuation, and is woken immediately by commands and configuration changes.
+ * Override commands are passed to the task via a lock-free {@link CommandMailbox}, so that all state
+ * changes happen on the task. The shared state is never locked while a controller is driven,
+ * so the main task never waits for valve I/O.
+ * Events are published from the main task, as the MQTT client is not thread-safe. The publishing loop polls
+ * the event queue often while commands are queued or the valves are moving, and rarely while they are idle.
+ *
+ * Allows opening and closing via {@link ValveHandler#override}.
+ * Handles remote MQTT commands to open and close the valves. Override commands may carry a <code>correlationId</code>
+ * and a <code>clientTime</code>; the timestamps of the command's way to the valve are reported with the resulting
+ * <code>valve/state</code> event, so that command latency can be measured end to end.
+ * Reports the valves' state via MQTT.
  */
 class ValveHandler
     : public TelemetryProvider,
-      public BaseTask {
+      public TelemetrySnapshotProvider,
+      public ProfiledTask {
 public:
     enum class State {
         CLOSED = -1,
@@ -36,22 +172,86 @@ public:
         OPEN = 1
     };
 
-    ValveHandler(TaskContainer& tasks, MqttHandler& mqtt, EventHandler& events, ValveController& controller)
-        : BaseTask(tasks, "ValveHandler")
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent)
+            : NamedConfigurationSection(parent, "actuation") {
+        }
+
+        /**
+         * @brief The maximum number of valves in their peak-drive phase at the same time, 0 means unlimited.
+         */
+        Property<int> maxConcurrentPeaks { this, "maxConcurrentPeaks", 1 };
+
+        /**
+         * @brief The maximum summed peak current of the valves in mA, 0 means unlimited.
+         */
+        Property<int> maxPeakCurrent { this, "maxPeakCurrent", 0 };
+
+        /**
+         * @brief Whether to verify via the flow meter that flow starts or stops after the valves are actuated.
+         */
+        Property<bool> verifyFlow { this, "verifyFlow", false };
+
+        /**
+         * @brief How long to wait for the flow to change after each drive pulse.
+         */
+        Property<seconds> verificationWindow { this, "verificationWindow", seconds { 10 } };
+
+        /**
+         * @brief The maximum number of drive pulses per actuation, including the first one.
+         */
+        Property<int> maxDriveAttempts { this, "maxDriveAttempts", 3 };
+
+        /**
+         * @brief The factor to stretch the drive pulse by on each retry.
+         */
+        Property<double> retryPulseEscalation { this, "retryPulseEscalation", 1.5 };
+    };
+
+    ValveHandler(TaskContainer& tasks, MqttHandler& mqtt, EventHandler& events, const Config& config, MeterHandler& flowMeter, const std::vector<ValveController*>& controllers)
+        : ProfiledTask(tasks, "ValveHandler")
         , events(events)
-        , controller(controller) {
+        , config(config)
+        , flowMeter(flowMeter) {
+        if (controllers.size() > VALVE_MAX_ZONES) {
+            fatalError("Too many valve zones");
+        }
+        zones.reserve(controllers.size());
+        for (size_t index = 0; index < controllers.size(); index++) {
+            auto controller = controllers[index];
+            zones.emplace_back(*controller);
+            controller->onPulseCompleted([this, index](bool open) {
+                completePulse(index, open);
+            });
+        }
+
         mqtt.registerCommand("override", [&](const JsonObject& request, JsonObject& response) {
+            size_t zoneIndex = request["zone"] | 0;
+            if (zoneIndex >= zones.size()) {
+                response["error"] = "Unknown zone";
+                return;
+            }
+            auto trace = CommandTrace::receive(
+                request["correlationId"].as<const char*>(),
+                request["clientTime"] | static_cast<int64_t>(0),
+                system_clock::now());
             State targetState = request["state"].as<State>();
             if (targetState == State::NONE) {
-                resume();
+                resume(zoneIndex);
             } else {
                 seconds duration = request.containsKey("duration")
                     ? request["duration"].as<seconds>()
                     : hours { 1 };
-                override(targetState, duration);
+                override(zoneIndex, targetState, duration, OverrideSource::MQTT, trace);
                 response["duration"] = duration;
             }
-            response["state"] = state;
+            // Only the receive time is known yet, the rest is reported with the valve/state event
+            populateCommandTrace(response, trace);
+            response["zone"] = zoneIndex;
+            // The valve is actuated asynchronously, report the requested state
+            response["state"] = targetState;
         });
     }
 
@@ -59,37 +259,102 @@ public:
         if (!enabled) {
             return;
         }
-        json["valve"] = state;
-        if (manualOverrideEnd != time_point<system_clock>()) {
-            time_t rawtime = system_clock::to_time_t(manualOverrideEnd);
-            auto timeinfo = gmtime(&rawtime);
-            char buffer[80];
-            strftime(buffer, 80, "%FT%TZ", timeinfo);
-            json["overrideEnd"] = string(buffer);
+        TRACE_SCOPE("valve/telemetry");
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (edgeLateness.getCount() > 0) {
+            JsonObject latenessJson = json.createNestedObject("lateness");
+            latenessJson["count"] = edgeLateness.getCount();
+            latenessJson["p50"] = edgeLateness.getPercentile(50).count();
+            latenessJson["p95"] = edgeLateness.getPercentile(95).count();
+            latenessJson["max"] = edgeLateness.getMax().count();
         }
+        if (zones.size() == 1) {
+            populateZoneTelemetry(json, zones.front());
+        } else {
+            JsonArray zonesJson = json.createNestedArray("zones");
+            for (auto& zone : zones) {
+                JsonObject zoneJson = zonesJson.createNestedObject();
+                populateZoneTelemetry(zoneJson, zone);
+            }
+        }
+    }
+
+    void populateSnapshot(JsonObject& json) override {
+        // Reporting the state has no side effects
+        populateTelemetry(json);
     }
 
     void begin() {
-        controller.reset();
+        for (size_t index = 0; index < zones.size(); index++) {
+            auto& zone = zones[index];
+            zone.controller.reset();
 
-        // RTC memory is reset to 0 upon power-up
-        if (valveHandlerStoredState == 0) {
-            Serial.println("Initializing for the first time");
-        } else {
-            Serial.println("Initializing after waking from sleep with state = " + String(valveHandlerStoredState));
-            state = valveHandlerStoredState == 1
-                ? State::OPEN
-                : State::CLOSED;
+            // RTC memory is reset to 0 upon power-up
+            int8_t storedState = valveHandlerStoredState[index];
+            if (storedState == 0) {
+                Serial.printf("Initializing zone %d for the first time\n", index);
+            } else {
+                Serial.printf("Initializing zone %d after waking from sleep with state = %d\n", index, storedState);
+                zone.state = storedState == 1
+                    ? State::OPEN
+                    : State::CLOSED;
+            }
+
+            // Restore the override before the first evaluation, so that it does not end on wake
+            StoredOverride storedOverride;
+            if (valveHandlerStoredOverrides[index].load(storedOverride)) {
+                zone.manualOverrideEnd = time_point<system_clock>(duration_cast<system_clock::duration>(microseconds { storedOverride.end }));
+                zone.overrideSource = storedOverride.source;
+                Serial.printf("Restored override of zone %d from source %d until %s\n",
+                    index, static_cast<int>(zone.overrideSource), formatTime(zone.manualOverrideEnd).c_str());
+            }
+        }
+        int64_t lastEvaluationMicros;
+        if (valveHandlerLastEvaluation.load(lastEvaluationMicros)) {
+            lastEvaluation = time_point<system_clock>(duration_cast<system_clock::duration>(microseconds { lastEvaluationMicros }));
+        }
+        valveHandlerEdgeLateness.load(edgeLateness);
+        if (config.maxConcurrentPeaks.get() < 0 || config.maxPeakCurrent.get() < 0) {
+            Serial.printf("Invalid actuation limits (maxConcurrentPeaks = %d, maxPeakCurrent = %d), negative values mean unlimited\n",
+                config.maxConcurrentPeaks.get(), config.maxPeakCurrent.get());
         }
         enabled = true;
+
+        // Run above the main loop's priority so that commands are actuated as soon as they arrive
+        xTaskCreate(runActuationTask, "ValveHandler", 4096, this, 2, &actuationTask);
+    }
+
+    /**
+     * @brief The task actuating the valves, or <code>nullptr</code> before {@link #begin}.
+     */
+    TaskHandle_t getActuationTask() const {
+        return actuationTask;
+    }
+
+    size_t getZoneCount() const {
+        return zones.size();
     }
 
-    void setSchedule(const JsonArray schedulesJson) {
+    /**
+     * @brief The next time a zone may need to change state, e.g. at a schedule edge or the end of an override.
+     */
+    time_point<system_clock> getNextChange() {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        return findNextChange(system_clock::now());
+    }
+
+    void setSchedule(size_t zoneIndex, const JsonArray schedulesJson) {
+        if (zoneIndex >= zones.size()) {
+            Serial.printf("Ignoring schedule for unknown zone %d\n", zoneIndex);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(stateMutex);
+        auto& schedules = zones[zoneIndex].schedules;
         schedules.clear();
         if (schedulesJson.isNull() || schedulesJson.size() == 0) {
-            Serial.println("No schedule defined");
+            Serial.printf("No schedule defined for zone %d\n", zoneIndex);
         } else {
-            Serial.println("Defining schedule:");
+            Serial.printf("Defining schedule for zone %d:\n", zoneIndex);
             for (JsonVariant scheduleJson : schedulesJson) {
                 schedules.emplace_back(scheduleJson.as<JsonObject>());
                 Serial.print(" - ");
@@ -97,78 +362,926 @@ public:
                 Serial.println();
             }
         }
+        wake();
+    }
+
+    /**
+     * @brief Sets the hydraulic capacity of the supply line, and the nominal flow rate of each zone in liters / min.
+     */
+    void setHydraulicLimits(size_t maxConcurrentZones, double maxFlow, const std::vector<double>& zoneFlowRates) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        planner.setLimits(maxConcurrentZones, maxFlow);
+        planner.setZoneFlowRates(zoneFlowRates);
+        updatePlan(system_clock::now());
+        wake();
+    }
+
+    void setPrograms(const JsonArray programsJson, const JsonArray windowsJson) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        programs.clear();
+        programWindows.clear();
+        if (programsJson.isNull() || programsJson.size() == 0) {
+            Serial.println("No zone programs defined");
+        } else {
+            Serial.println("Defining zone programs:");
+            for (JsonObject programJson : programsJson) {
+                RecurringProgram program;
+                program.program.start = parseIsoDate(programJson["start"].as<const char*>());
+                program.period = seconds { programJson["period"] | 0 };
+                for (JsonObject stepJson : programJson["steps"].as<JsonArray>()) {
+                    size_t zoneIndex = stepJson["zone"] | 0;
+                    if (zoneIndex >= zones.size()) {
+                        Serial.printf("Ignoring program step for unknown zone %d\n", zoneIndex);
+                        continue;
+                    }
+                    program.program.steps.push_back(ZoneProgramStep {
+                        zoneIndex,
+                        seconds { stepJson["duration"] | 0 },
+                        stepJson["volume"] | 0.0 });
+                }
+                programs.push_back(program);
+                Serial.print(" - ");
+                serializeJson(programJson, Serial);
+                Serial.println();
+            }
+            for (JsonVariant windowJson : windowsJson) {
+                programWindows.emplace_back(windowJson.as<JsonObject>());
+            }
+        }
+        planningHorizonStart = time_point<system_clock>();
+        updatePlan(system_clock::now());
+        wake();
+    }
+
+    /**
+     * @brief Overrides the zone's schedule; must be called from the main task, like all commands.
+     */
+    void override(size_t zoneIndex, State state, seconds duration, OverrideSource source = OverrideSource::MQTT, const CommandTrace& trace = CommandTrace()) {
+        post({ zoneIndex, state, system_clock::now() + duration, source, trace });
+    }
+
+    void overrideAll(State state, seconds duration, OverrideSource source = OverrideSource::MQTT) {
+        auto end = system_clock::now() + duration;
+        for (size_t index = 0; index < zones.size(); index++) {
+            post({ index, state, end, source });
+        }
     }
 
-    void override(State state, seconds duration) {
-        Serial.printf("Overriding valve to %d for %d seconds\n", static_cast<int>(state), duration.count());
-        manualOverrideEnd = system_clock::now() + duration;
-        setState(state);
+    void resume(size_t zoneIndex) {
+        post({ zoneIndex, State::NONE, time_point<system_clock>(), OverrideSource::NONE });
     }
 
-    void resume() {
-        Serial.println("Normal valve operation resumed");
-        manualOverrideEnd = time_point<system_clock>();
+    /**
+     * @brief Resumes normal operation of the zones overridden by the given source, leaving other overrides in place.
+     */
+    void resumeAll(OverrideSource source) {
+        for (size_t index = 0; index < zones.size(); index++) {
+            post({ index, State::NONE, time_point<system_clock>(), source });
+        }
     }
 
 protected:
+    /**
+     * @brief Publishes the events queued by the actuation task.
+     */
     const Schedule loop(const Timing& timing) override {
-        if (!enabled || schedules.empty()) {
-            return sleepIndefinitely();
+        PROFILE_LOOP();
+        std::list<QueuedEvent> queuedEvents;
+        bool busy;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            queuedEvents.swap(eventQueue);
+            // More events are likely to follow while the valves are busy
+            busy = !commands.isEmpty()
+                || isTransitionInProgress(boot_clock::now())
+                || verifier.isActive();
+        }
+        for (auto& event : queuedEvents) {
+            TRACE_SCOPE("mqtt/publish");
+            events.publishEvent(event.name, event.populate);
         }
+        return profiledSleepFor(busy || !queuedEvents.empty()
+                ? duration_cast<microseconds>(VALVE_EVENT_PUBLISH_INTERVAL)
+                : duration_cast<microseconds>(VALVE_EVENT_IDLE_PUBLISH_INTERVAL));
+    }
 
-        if (manualOverrideEnd < system_clock::now()) {
-            if (manualOverrideEnd != time_point<system_clock>()) {
-                resume();
+private:
+    /**
+     * @brief Overrides the zone to the given state until the given time, or resumes normal operation if the state is NONE.
+     *
+     * When resuming, a source other than NONE only clears overrides made by the same source.
+     */
+    struct Command {
+        size_t zone;
+        State state;
+        time_point<system_clock> overrideEnd;
+        OverrideSource source;
+        CommandTrace trace;
+    };
+
+    void post(const Command& command) {
+        if (!commands.post(command)) {
+            Serial.printf("Too many pending valve commands, dropping command for zone %d\n", command.zone);
+            return;
+        }
+        wake();
+    }
+
+    void processCommands() {
+        Command command;
+        while (commands.take(command)) {
+            TRACE_INSTANT("valve/command");
+            if (command.state == State::NONE) {
+                if (command.source == OverrideSource::NONE || command.source == zones[command.zone].overrideSource) {
+                    clearOverride(command.zone);
+                }
+                continue;
             }
+            auto duration = duration_cast<seconds>(command.overrideEnd - system_clock::now());
+            Serial.printf("Overriding zone %d to %d for %ld seconds\n",
+                command.zone, static_cast<int>(command.state), (long) duration.count());
+            auto& zone = zones[command.zone];
+            zone.manualOverrideEnd = command.overrideEnd;
+            zone.overrideSource = command.source;
+            valveHandlerStoredOverrides[command.zone].store(StoredOverride {
+                duration_cast<microseconds>(command.overrideEnd.time_since_epoch()).count(),
+                command.source });
+            if (command.trace.isActive()) {
+                command.trace.dequeued = CommandTrace::toMicros(system_clock::now());
+            }
+            requestState(command.zone, command.state, time_point<system_clock>(), command.trace);
+        }
+    }
+
+    struct QueuedEvent {
+        const char* name;
+        std::function<void(JsonObject&)> populate;
+    };
+
+    static void runActuationTask(void* param) {
+        static_cast<ValveHandler*>(param)->runActuation();
+    }
+
+    void runActuation() {
+        while (true) {
+            microseconds timeout;
+            {
+                PROFILE_LOOP_OF(actuationProfile);
+                timeout = evaluate();
+            }
+            actuationProfile.recordSleep(timeout);
+            // Round up so that we do not wake before the deadline
+            TickType_t ticks = (duration_cast<milliseconds>(timeout).count() + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+            ulTaskNotifyTake(pdTRUE, ticks);
+        }
+    }
+
+    /**
+     * @brief Queues an event to be published from the main task; must be called with the state locked.
+     */
+    void queueEvent(const char* name, std::function<void(JsonObject&)> populate) {
+        eventQueue.push_back({ name, populate });
+    }
+
+    /**
+     * @brief Wakes the actuation task to re-evaluate the zones immediately.
+     */
+    void wake() {
+        if (actuationTask != nullptr) {
+            xTaskNotifyGive(actuationTask);
+        }
+    }
+
+    void clearOverride(size_t zoneIndex) {
+        Serial.printf("Normal operation resumed for zone %d\n", zoneIndex);
+        zones[zoneIndex].manualOverrideEnd = time_point<system_clock>();
+        zones[zoneIndex].overrideSource = OverrideSource::NONE;
+        valveHandlerStoredOverrides[zoneIndex].invalidate();
+    }
+
+    /**
+     * @brief Evaluates every zone in a single pass, and returns how long until the next deadline.
+     *
+     * The state is only locked while deciding what to drive and while recording the results.
+     * The controllers are driven in between with the state unlocked, so that the main task
+     * never waits for a valve pulse to finish.
+     */
+    microseconds evaluate() {
+        TRACE_SCOPE("valve/evaluate");
+        std::vector<DueActuation> due;
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            processCommands();
+            auto bootNow = boot_clock::now();
+            for (size_t index = 0; index < zones.size(); index++) {
+                checkAwaitedPulse(index, bootNow);
+            }
+            updateTargetStates(system_clock::now());
+            verifyActuation();
+            takeDueActuations(due);
+        }
 
-            auto targetState = scheduler.isScheduled(schedules, system_clock::now())
+        for (auto& actuation : due) {
+            drive(actuation);
+        }
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        completeActuations(due);
+
+        auto now = system_clock::now();
+        auto nextChange = std::min(now + VALVE_MAX_EVALUATION_INTERVAL, findNextChange(now));
+        auto bootNow = boot_clock::now();
+        time_point<boot_clock> deadline = bootNow + duration_cast<boot_clock::duration>(nextChange - now);
+        for (auto& actuation : pendingActuations) {
+            deadline = std::min(deadline, actuation.due);
+        }
+        for (auto& zone : zones) {
+            if (zone.awaitedPulse.active) {
+                deadline = std::min(deadline, zone.awaitedPulse.deadline);
+            }
+        }
+        deadline = std::min(deadline, verifier.getDeadline(flowMeter.getLastSeenFlow()));
+        return std::max(duration_cast<microseconds>(deadline - bootNow), microseconds::zero());
+    }
+
+    /**
+     * @brief Requests the state changes needed for the zones to follow their schedules and programs; must be called with the state locked.
+     */
+    void updateTargetStates(time_point<system_clock> now) {
+        updatePlan(now);
+        for (size_t index = 0; index < zones.size(); index++) {
+            auto& zone = zones[index];
+            if (zone.manualOverrideEnd >= now) {
+                continue;
+            }
+            if (zone.schedules.empty() && programs.empty()) {
+                continue;
+            }
+            if (zone.manualOverrideEnd != time_point<system_clock>()) {
+                clearOverride(index);
+            }
+
+            auto targetState = scheduler.isScheduled(zone.schedules, now) || planner.isZoneActive(index, now)
                 ? State::OPEN
                 : State::CLOSED;
 
-            if (state != targetState) {
+            if (zone.state != targetState && !isActuationPending(index)) {
                 switch (targetState) {
                     case State::OPEN:
-                        Serial.println("Opening on schedule");
+                        Serial.printf("Opening zone %d on schedule\n", index);
                         break;
                     case State::CLOSED:
-                        Serial.println("Closing on schedule");
+                        Serial.printf("Closing zone %d on schedule\n", index);
                         break;
                 }
-                setState(targetState);
+                requestState(index, targetState, findScheduleEdge(zone, now));
             }
         }
+        lastEvaluation = now;
+        valveHandlerLastEvaluation.store(duration_cast<microseconds>(now.time_since_epoch()).count());
+    }
 
-        return sleepFor(seconds { 1 });
+    /**
+     * @brief The next schedule edge, planned program change or override end after the given time; must be called with the state locked.
+     */
+    time_point<system_clock> findNextChange(time_point<system_clock> now) {
+        auto nextChange = time_point<system_clock>::max();
+        if (!programs.empty()) {
+            nextChange = std::min(nextChange, planner.getNextChange(now));
+        }
+        for (auto& zone : zones) {
+            if (zone.manualOverrideEnd >= now) {
+                nextChange = std::min(nextChange, zone.manualOverrideEnd);
+            } else {
+                nextChange = std::min(nextChange, scheduler.getNextChange(zone.schedules, now));
+            }
+        }
+        return nextChange;
     }
 
-private:
-    void setState(State state) {
-        this->state = state;
-        switch (state) {
+    /**
+     * @brief The last actuation of a zone, until its drive pulse has completed and its state has been reported.
+     */
+    struct AwaitedPulse {
+        bool active;
+        State state;
+
+        /**
+         * @brief The number of drive pulses the zone's controller had completed before this actuation.
+         */
+        uint32_t pulsesBefore;
+
+        /**
+         * @brief When to give up waiting for the pulse to complete.
+         */
+        time_point<boot_clock> deadline;
+
+        /**
+         * @brief The schedule edge the actuation was for, or the epoch if it was not for a known edge.
+         */
+        time_point<system_clock> edge;
+        CommandTrace trace;
+    };
+
+    struct Zone {
+        Zone(ValveController& controller)
+            : controller(controller) {
+        }
+
+        ValveController& controller;
+        std::list<ValveSchedule> schedules;
+        time_point<system_clock> manualOverrideEnd;
+        OverrideSource overrideSource = OverrideSource::NONE;
+        State state = State::NONE;
+
+        /**
+         * @brief The number of drive pulses the controller has completed, and the direction and end of the last one; guarded by the pulse lock.
+         */
+        uint32_t completedPulses = 0;
+        bool lastPulseOpen = false;
+        time_point<system_clock> lastPulseEnd;
+
+        AwaitedPulse awaitedPulse {};
+    };
+
+    void populateZoneTelemetry(JsonObject& json, const Zone& zone) {
+        json["valve"] = zone.state;
+        if (zone.manualOverrideEnd != time_point<system_clock>()) {
+            json["overrideEnd"] = formatTime(zone.manualOverrideEnd);
+            json["overrideSource"] = static_cast<int>(zone.overrideSource);
+        }
+    }
+
+    static string formatTime(time_point<system_clock> time) {
+        time_t rawtime = system_clock::to_time_t(time);
+        auto timeinfo = gmtime(&rawtime);
+        char buffer[80];
+        strftime(buffer, 80, "%FT%TZ", timeinfo);
+        return string(buffer);
+    }
+
+    struct RecurringProgram {
+        ZoneProgram program;
+        /**
+         * @brief How often the program repeats, zero for one-off programs.
+         */
+        seconds period;
+    };
+
+    /**
+     * @brief Expands recurring programs and windows over a planning horizon that moves once a day,
+     * so that configuration changes can be replanned incrementally.
+     */
+    void updatePlan(time_point<system_clock> now) {
+        const hours day { 24 };
+        auto today = time_point<system_clock>(duration_cast<hours>(now.time_since_epoch()) / day * day);
+        auto horizonStart = today - day;
+        if (horizonStart == planningHorizonStart) {
+            return;
+        }
+        planningHorizonStart = horizonStart;
+        auto horizonEnd = today + 2 * day;
+
+        std::vector<ZoneProgramPlanner::Window> windows;
+        for (auto& window : programWindows) {
+            forEachOccurrence(window.start, window.period, horizonStart - window.duration, horizonEnd, [&](time_point<system_clock> start) {
+                windows.push_back({ start, start + window.duration });
+            });
+        }
+
+        std::vector<ZoneProgram> occurrences;
+        for (auto& program : programs) {
+            forEachOccurrence(program.program.start, program.period, horizonStart, horizonEnd, [&](time_point<system_clock> start) {
+                occurrences.push_back(ZoneProgram { start, program.program.steps });
+            });
+        }
+        std::stable_sort(occurrences.begin(), occurrences.end(), [](const ZoneProgram& a, const ZoneProgram& b) {
+            return a.start < b.start;
+        });
+
+        planner.setWindows(windows);
+        planner.setPrograms(occurrences);
+        for (size_t index = 0; index < occurrences.size(); index++) {
+            if (planner.isPlanned(index)) {
+                continue;
+            }
+            auto& steps = occurrences[index].steps;
+            auto unknown = std::find_if(steps.begin(), steps.end(), [this](const ZoneProgramStep& step) {
+                return !planner.hasKnownDuration(step);
+            });
+            if (unknown != steps.end()) {
+                Serial.printf("Zone program starting at %s has a volume step for zone %d without a flow rate\n",
+                    formatTime(occurrences[index].start).c_str(), (int) unknown->zone);
+            } else {
+                Serial.printf("Zone program starting at %s does not fit the available windows\n",
+                    formatTime(occurrences[index].start).c_str());
+            }
+        }
+    }
+
+    template <typename F>
+    static void forEachOccurrence(time_point<system_clock> start, seconds period, time_point<system_clock> from, time_point<system_clock> until, F callback) {
+        if (period <= seconds::zero()) {
+            if (start >= from && start < until) {
+                callback(start);
+            }
+            return;
+        }
+        auto first = start;
+        if (first < from) {
+            first += (from - start) / period * period;
+            if (first < from) {
+                first += period;
+            }
+        }
+        for (auto occurrence = first; occurrence < until; occurrence += period) {
+            callback(occurrence);
+        }
+    }
+
+    struct PendingActuation {
+        size_t zone;
+        State state;
+        time_point<boot_clock> due;
+
+        /**
+         * @brief The schedule edge that triggered the actuation, or the epoch if it was not triggered by one.
+         */
+        time_point<system_clock> edge;
+
+        /**
+         * @brief The remote command that triggered the actuation, inactive if it was not triggered by one.
+         */
+        CommandTrace trace;
+
+        /**
+         * @brief Whether this re-issues the drive pulse of an actuation that could not be verified.
+         */
+        bool retry;
+
+        /**
+         * @brief The factor to stretch the peak phase of the drive pulse by.
+         */
+        double pulseScale;
+    };
+
+    bool isActuationPending(size_t zoneIndex) {
+        for (auto& actuation : pendingActuations) {
+            if (actuation.zone == zoneIndex) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Plans a state change for the zone's valve within the peak budget.
+     *
+     * A pending request for the same zone is replaced.
+     */
+    void requestState(size_t zoneIndex, State state, time_point<system_clock> edge = time_point<system_clock>(), const CommandTrace& trace = CommandTrace()) {
+        for (auto& actuation : pendingActuations) {
+            if (actuation.zone == zoneIndex) {
+                actuation.state = state;
+                actuation.edge = edge;
+                actuation.trace = trace;
+                actuation.retry = false;
+                actuation.pulseScale = 1.0;
+                verifyTransition = true;
+                return;
+            }
+        }
+
+        // A new state change supersedes the verification of the previous one
+        verifier.cancel();
+
+        if (!isTransitionInProgress(boot_clock::now())) {
+            flowBeforeTransition = getNominalFlow();
+            flowRateBeforeTransition = flowMeter.getFlowRate();
+        }
+        planActuation({ zoneIndex, state, time_point<boot_clock>(), edge, trace, false, 1.0 });
+        verifyTransition = true;
+    }
+
+    /**
+     * @brief Re-issues the drive pulses of the last transition, stretched by the given factor, within the peak budget.
+     */
+    void requestRetry(double pulseScale) {
+        std::vector<size_t> retriedZones;
+        for (auto& slot : peakSlots) {
+            retriedZones.push_back(slot.zone);
+        }
+        for (auto zoneIndex : retriedZones) {
+            if (!isActuationPending(zoneIndex)) {
+                planActuation({ zoneIndex, zones[zoneIndex].state, time_point<boot_clock>(), time_point<system_clock>(), CommandTrace(), true, pulseScale });
+            }
+        }
+    }
+
+    bool isTransitionInProgress(time_point<boot_clock> now) {
+        return !pendingActuations.empty()
+            || duration_cast<milliseconds>(now - transitionStart) < ActuationScheduler::getMakespan(peakSlots);
+    }
+
+    /**
+     * @brief Schedules the actuation's peak phase, starting a new transition if none is in progress.
+     */
+    void planActuation(PendingActuation actuation) {
+        auto now = boot_clock::now();
+        auto offset = duration_cast<milliseconds>(now - transitionStart);
+        if (!isTransitionInProgress(now)) {
+            transitionStart = now;
+            offset = milliseconds::zero();
+            peakSlots.clear();
+            verifyTransition = false;
+        }
+
+        auto& controller = zones[actuation.zone].controller;
+        // Negative limits are invalid, treat them as unlimited instead of wrapping around
+        ActuationScheduler actuationScheduler(
+            static_cast<size_t>(std::max(config.maxConcurrentPeaks.get(), 0)),
+            static_cast<uint32_t>(std::max(config.maxPeakCurrent.get(), 0)));
+        auto slot = actuationScheduler.plan(peakSlots,
+            ActuationScheduler::Request {
+                actuation.zone,
+                duration_cast<milliseconds>(controller.getPeakDuration(actuation.state == State::OPEN) * actuation.pulseScale),
+                controller.getPeakCurrent() },
+            offset);
+        actuation.due = transitionStart + slot.start;
+        pendingActuations.push_back(actuation);
+    }
+
+    /**
+     * @brief The schedule edge that the zone's state is changing for, or the epoch if the edge is not known.
+     *
+     * Only edges passed since the last evaluation are considered, so that a schedule that has just been set,
+     * or the first evaluation after power-up, is not mistaken for a late edge.
+     * Zone programs are planned, so their transitions are not measured.
+     */
+    time_point<system_clock> findScheduleEdge(const Zone& zone, time_point<system_clock> now) {
+        if (!programs.empty() || lastEvaluation == time_point<system_clock>()) {
+            return time_point<system_clock>();
+        }
+        auto edge = scheduler.getLastChange(zone.schedules, now);
+        if (edge <= lastEvaluation) {
+            return time_point<system_clock>();
+        }
+        return edge;
+    }
+
+    /**
+     * @brief An actuation taken off the pending list to be driven with the state unlocked.
+     */
+    struct DueActuation {
+        PendingActuation actuation;
+        time_point<boot_clock> started;
+
+        /**
+         * @brief The number of drive pulses the zone's controller has completed before this actuation.
+         */
+        uint32_t pulsesBefore;
+    };
+
+    /**
+     * @brief Moves the actuations that are due to the given list; must be called with the state locked.
+     */
+    void takeDueActuations(std::vector<DueActuation>& due) {
+        auto now = boot_clock::now();
+        for (auto it = pendingActuations.begin(); it != pendingActuations.end();) {
+            if (it->due > now) {
+                ++it;
+                continue;
+            }
+            due.push_back({ *it, time_point<boot_clock>(), 0 });
+            it = pendingActuations.erase(it);
+        }
+    }
+
+    /**
+     * @brief Records the outcome of the driven actuations, and completes the transition when nothing is pending anymore; must be called with the state locked.
+     */
+    void completeActuations(const std::vector<DueActuation>& due) {
+        if (due.empty()) {
+            return;
+        }
+        for (auto& driven : due) {
+            auto& actuation = driven.actuation;
+            size_t zoneIndex = actuation.zone;
+            // Controllers may return before the peak is over, or block for its duration
+            time_point<boot_clock> plannedPeakEnd = driven.started
+                + duration_cast<milliseconds>(zones[zoneIndex].controller.getPeakDuration(actuation.state == State::OPEN) * actuation.pulseScale);
+            auto now = boot_clock::now();
+            time_point<boot_clock> peakEnd = std::max(plannedPeakEnd, now);
+
+            if (!actuation.retry) {
+                recordState(zoneIndex, actuation.state);
+                auto& awaited = zones[zoneIndex].awaitedPulse;
+                if (awaited.active) {
+                    // Superseded before its pulse has completed
+                    reportState(zoneIndex, time_point<system_clock>());
+                }
+                awaited = AwaitedPulse {
+                    true,
+                    actuation.state,
+                    driven.pulsesBefore,
+                    plannedPeakEnd + VALVE_PULSE_COMPLETION_TIMEOUT,
+                    actuation.edge,
+                    actuation.trace
+                };
+                // Controllers that block for the pulse have completed it by now
+                checkAwaitedPulse(zoneIndex, now);
+            }
+
+            for (auto slot = peakSlots.rbegin(); slot != peakSlots.rend(); ++slot) {
+                if (slot->zone == zoneIndex) {
+                    slot->end = duration_cast<milliseconds>(peakEnd - transitionStart);
+                    break;
+                }
+            }
+        }
+        if (pendingActuations.empty()) {
+            auto transitionDuration = ActuationScheduler::getMakespan(peakSlots);
+            size_t zoneCount = peakSlots.size();
+            Serial.printf("Transition of %d zone(s) completes in %ld ms\n",
+                zoneCount, (long) transitionDuration.count());
+            if (zoneCount > 1) {
+                queueEvent("valve/transition", [=](JsonObject& json) {
+                    json["zones"] = zoneCount;
+                    json["duration"] = transitionDuration.count();
+                });
+            }
+            // Retries are verified as part of the original transition
+            if (config.verifyFlow.get() && verifyTransition) {
+                startVerification();
+            }
+        }
+    }
+
+    /**
+     * @brief The flow expected through the zones' valves in their current state.
+     */
+    struct NominalFlow {
+        bool anyOpen;
+
+        /**
+         * @brief The summed nominal flow rate of the open zones in liters / min.
+         */
+        double rate;
+    };
+
+    NominalFlow getNominalFlow() {
+        NominalFlow flow { false, 0.0 };
+        for (size_t index = 0; index < zones.size(); index++) {
+            if (zones[index].state == State::OPEN) {
+                flow.anyOpen = true;
+                flow.rate += planner.getFlowRate(index);
+            }
+        }
+        return flow;
+    }
+
+    /**
+     * @brief Called by the controllers when a drive pulse has finished, possibly from a timer task.
+     */
+    void completePulse(size_t zoneIndex, bool open) {
+        auto now = system_clock::now();
+        auto& zone = zones[zoneIndex];
+        portENTER_CRITICAL(&pulseLock);
+        zone.completedPulses++;
+        zone.lastPulseOpen = open;
+        zone.lastPulseEnd = now;
+        portEXIT_CRITICAL(&pulseLock);
+        wake();
+    }
+
+    /**
+     * @brief Reports the zone's state once the drive pulse of its last actuation has completed, or waiting for it has timed out;
+     * must be called with the state locked.
+     */
+    void checkAwaitedPulse(size_t zoneIndex, time_point<boot_clock> now) {
+        auto& zone = zones[zoneIndex];
+        if (!zone.awaitedPulse.active) {
+            return;
+        }
+        portENTER_CRITICAL(&pulseLock);
+        // A pulse queued before ours may complete first
+        bool completed = zone.completedPulses != zone.awaitedPulse.pulsesBefore
+            && zone.lastPulseOpen == (zone.awaitedPulse.state == State::OPEN);
+        auto pulseEnd = zone.lastPulseEnd;
+        portEXIT_CRITICAL(&pulseLock);
+        if (completed) {
+            reportState(zoneIndex, pulseEnd);
+        } else if (now >= zone.awaitedPulse.deadline) {
+            Serial.printf("Zone %d did not report the end of its drive pulse in time\n", zoneIndex);
+            reportState(zoneIndex, time_point<system_clock>());
+        }
+    }
+
+    /**
+     * @brief Reports the zone's awaited state along with its trace, and measures how late a scheduled actuation was;
+     * the pulse end is the epoch if it is not known. Must be called with the state locked.
+     */
+    void reportState(size_t zoneIndex, time_point<system_clock> pulseEnd) {
+        auto& awaited = zones[zoneIndex].awaitedPulse;
+        awaited.active = false;
+        bool known = pulseEnd != time_point<system_clock>();
+        if (known && awaited.trace.isActive()) {
+            awaited.trace.actuationCompleted = CommandTrace::toMicros(pulseEnd);
+        }
+        if (known && awaited.edge != time_point<system_clock>()) {
+            auto lateness = duration_cast<milliseconds>(pulseEnd - awaited.edge);
+            edgeLateness.add(lateness);
+            valveHandlerEdgeLateness.store(edgeLateness);
+            Serial.printf("Zone %d actuated %ld ms after schedule edge\n", zoneIndex, (long) lateness.count());
+        }
+        State state = awaited.state;
+        CommandTrace trace = awaited.trace;
+        queueEvent("valve/state", [=](JsonObject& json) {
+            json["zone"] = zoneIndex;
+            json["state"] = state;
+            populateCommandTrace(json, trace);
+        });
+    }
+
+    /**
+     * @brief Starts verifying the change in flow the transition should have caused.
+     *
+     * When flow starts or stops with the transition, it is enough to see whether there is any flow.
+     * When other zones keep flowing, the flow rate needs to change by the nominal flow rate of the actuated zones.
+     */
+    void startVerification() {
+        auto flowAfterTransition = getNominalFlow();
+        verifier = FlowVerifier<boot_clock>(
+            config.verificationWindow.get(),
+            2 * flowMeter.getMeasurementFrequency(),
+            config.maxDriveAttempts.get(),
+            config.retryPulseEscalation.get());
+        if (!flowBeforeTransition.anyOpen || !flowAfterTransition.anyOpen) {
+            verifier.start(flowAfterTransition.anyOpen, transitionStart);
+            return;
+        }
+        double expectedChange = flowAfterTransition.rate - flowBeforeTransition.rate;
+        if (expectedChange == 0.0) {
+            Serial.println("Cannot verify transition while other zones are flowing without their nominal flow rates");
+            return;
+        }
+        verifier.startRateChange(flowRateBeforeTransition, expectedChange, transitionStart);
+    }
+
+    /**
+     * @brief Checks the flow after the last transition, and schedules a retry if needed; must be called with the state locked.
+     */
+    void verifyActuation() {
+        auto result = verifier.update(boot_clock::now(), flowMeter.getLastSeenFlow(), flowMeter.getFlowRate());
+        switch (result) {
+            case FlowVerifier<boot_clock>::Result::RETRY: {
+                TRACE_INSTANT("valve/retry");
+                Serial.printf("Flow did not %s, retrying with pulse stretched by %.2f (attempt %d)\n",
+                    verifier.isVerifyingRateChange() ? "change" : verifier.isExpectingFlow() ? "start" : "stop",
+                    verifier.getPulseScale(),
+                    verifier.getAttempts());
+                requestRetry(verifier.getPulseScale());
+                break;
+            }
+            case FlowVerifier<boot_clock>::Result::VERIFIED:
+            case FlowVerifier<boot_clock>::Result::FAILED: {
+                bool verified = result == FlowVerifier<boot_clock>::Result::VERIFIED;
+                bool expectFlow = verifier.isExpectingFlow();
+                auto latency = verifier.getLatency();
+                int attempts = verifier.getAttempts();
+                Serial.printf("Flow %s %s after %ld ms and %d attempt(s)\n",
+                    expectFlow ? "start" : "stop",
+                    verified ? "verified" : "could not be verified",
+                    (long) latency.count(), attempts);
+                queueEvent("valve/verification", [=](JsonObject& json) {
+                    json["verified"] = verified;
+                    json["flow"] = expectFlow;
+                    json["latency"] = latency.count();
+                    json["attempts"] = attempts;
+                });
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief Drives the zone's valve; must be called with the state unlocked, as controllers may block for the duration of the pulse.
+     *
+     * An active trace gets the actuation's start time; it is completed when the controller reports the end of the pulse.
+     */
+    void drive(DueActuation& driven) {
+        TRACE_SCOPE("valve/actuate");
+        auto& actuation = driven.actuation;
+        auto& zone = zones[actuation.zone];
+        portENTER_CRITICAL(&pulseLock);
+        driven.pulsesBefore = zone.completedPulses;
+        portEXIT_CRITICAL(&pulseLock);
+        driven.started = boot_clock::now();
+        if (actuation.trace.isActive()) {
+            actuation.trace.actuationStarted = CommandTrace::toMicros(system_clock::now());
+        }
+        auto& controller = zone.controller;
+        if (actuation.retry) {
+            Serial.printf("Retrying zone %d\n", actuation.zone);
+            controller.retry(actuation.state == State::OPEN, actuation.pulseScale);
+            return;
+        }
+        switch (actuation.state) {
             case State::OPEN:
-                Serial.println("Opening");
-                valveHandlerStoredState = 1;
+                Serial.printf("Opening zone %d\n", actuation.zone);
                 controller.open();
                 break;
             case State::CLOSED:
-                Serial.println("Closing");
-                valveHandlerStoredState = -1;
+                Serial.printf("Closing zone %d\n", actuation.zone);
                 controller.close();
                 break;
         }
-        events.publishEvent("valve/state", [=](JsonObject& json) {
-            json["state"] = state;
-        });
+    }
+
+    /**
+     * @brief Records the zone's new state; it is reported once the drive pulse has completed. Must be called with the state locked.
+     */
+    void recordState(size_t zoneIndex, State state) {
+        zones[zoneIndex].state = state;
+        valveHandlerStoredState[zoneIndex] = state == State::OPEN ? 1 : -1;
+    }
+
+    /**
+     * @brief Reports the command's timestamps under <code>command</code>, along with the correlation ID and client time if given.
+     */
+    static void populateCommandTrace(JsonObject& json, const CommandTrace& trace) {
+        if (!trace.isActive()) {
+            return;
+        }
+        JsonObject traceJson = json.createNestedObject("command");
+        if (trace.hasCorrelationId()) {
+            traceJson["correlationId"] = trace.correlationId;
+        }
+        if (trace.clientTime != 0) {
+            traceJson["clientTime"] = trace.clientTime;
+        }
+        traceJson["received"] = trace.received;
+        if (trace.dequeued != 0) {
+            traceJson["dequeued"] = trace.dequeued;
+        }
+        if (trace.actuationStarted != 0) {
+            traceJson["actuationStarted"] = trace.actuationStarted;
+        }
+        if (trace.actuationCompleted != 0) {
+            traceJson["actuationCompleted"] = trace.actuationCompleted;
+        }
     }
 
     ValveScheduler scheduler;
     EventHandler& events;
-    ValveController& controller;
+    const Config& config;
+    MeterHandler& flowMeter;
+
+    /**
+     * @brief Guards the configuration and telemetry state shared between the actuation task and the main task.
+     */
+    std::mutex stateMutex;
+    CommandMailbox<Command, VALVE_MAX_ZONES * 2> commands;
+    TaskHandle_t actuationTask = nullptr;
+    LoopProfile actuationProfile { "ValveActuation" };
+    std::list<QueuedEvent> eventQueue;
 
-    State state = State::NONE;
-    time_point<system_clock> manualOverrideEnd;
+    std::vector<Zone> zones;
     bool enabled = false;
-    std::list<ValveSchedule> schedules;
+
+    std::vector<RecurringProgram> programs;
+    std::list<ValveSchedule> programWindows;
+    ZoneProgramPlanner planner;
+    time_point<system_clock> planningHorizonStart;
+
+    std::list<PendingActuation> pendingActuations;
+    std::vector<ActuationScheduler::Slot> peakSlots;
+    time_point<boot_clock> transitionStart;
+
+    /**
+     * @brief Whether the transition changes any zone's state, as opposed to only retrying drive pulses.
+     */
+    bool verifyTransition = false;
+    NominalFlow flowBeforeTransition { false, 0.0 };
+    double flowRateBeforeTransition = 0.0;
+
+    /**
+     * @brief The time of the last evaluation, to tell which schedule edges have passed since.
+     */
+    time_point<system_clock> lastEvaluation;
+
+    /**
+     * @brief How long after the schedule edge the drive pulses of scheduled transitions have completed.
+     */
+    LatenessHistogram edgeLateness {};
+
+    /**
+     * @brief Guards the pulse completions reported by the controllers.
+     */
+    portMUX_TYPE pulseLock = portMUX_INITIALIZER_UNLOCKED;
+    FlowVerifier<boot_clock> verifier { seconds { 10 }, seconds { 2 }, 1, 1.0 };
 };
 
 bool convertToJson(const ValveHandler::State& src, JsonVariant dst) {
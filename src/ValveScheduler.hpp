@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <list>
 
@@ -13,6 +14,16 @@ using std::chrono::seconds;
 using std::chrono::system_clock;
 using std::chrono::time_point;
 
+/**
+ * @brief Parses an ISO 8601 UTC timestamp like <code>2020-01-01T00:00:00Z</code>.
+ */
+inline time_point<system_clock> parseIsoDate(const char* value) {
+    std::istringstream in(value);
+    time_point<system_clock> date;
+    in >> date::parse("%FT%TZ", date);
+    return date;
+}
+
 class ValveSchedule {
 public:
     ValveSchedule(
@@ -47,14 +58,6 @@ public:
     const time_point<system_clock> start;
     const seconds period;
     const seconds duration;
-
-private:
-    static time_point<system_clock> parseIsoDate(const char* value) {
-        std::istringstream in(value);
-        time_point<system_clock> date;
-        in >> date::parse("%FT%TZ", date);
-        return date;
-    }
 };
 
 class ValveScheduler {
@@ -74,4 +77,45 @@ public:
         }
         return false;
     }
+
+    /**
+     * @brief The next time after the given time at which any of the schedules starts or ends,
+     * or the maximum time point if there are no schedules.
+     */
+    time_point<system_clock> getNextChange(const std::list<ValveSchedule>& schedules, time_point<system_clock> time) {
+        auto next = time_point<system_clock>::max();
+        for (auto& schedule : schedules) {
+            if (time < schedule.start) {
+                next = std::min(next, schedule.start);
+                continue;
+            }
+            auto offset = (time - schedule.start) % schedule.period;
+            time_point<system_clock> periodStart = time - offset;
+            time_point<system_clock> change = offset < schedule.duration
+                ? periodStart + schedule.duration
+                : periodStart + schedule.period;
+            next = std::min(next, change);
+        }
+        return next;
+    }
+
+    /**
+     * @brief The last time at or before the given time at which any of the schedules started or ended,
+     * or the minimum time point if none of the schedules have started yet.
+     */
+    time_point<system_clock> getLastChange(const std::list<ValveSchedule>& schedules, time_point<system_clock> time) {
+        auto last = time_point<system_clock>::min();
+        for (auto& schedule : schedules) {
+            if (time < schedule.start) {
+                continue;
+            }
+            auto offset = (time - schedule.start) % schedule.period;
+            time_point<system_clock> periodStart = time - offset;
+            time_point<system_clock> change = offset < schedule.duration
+                ? periodStart
+                : periodStart + schedule.duration;
+            last = std::max(last, change);
+        }
+        return last;
+    }
 };
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using std::chrono::duration_cast;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+/**
+ * @brief A single step of a zone program: irrigate the zone for a duration, or until a volume has been delivered.
+ */
+struct ZoneProgramStep {
+    size_t zone;
+
+    /**
+     * @brief How long to irrigate the zone; when zero, the volume is used instead.
+     */
+    seconds duration;
+
+    /**
+     * @brief The volume to deliver in liters, converted to a duration via the zone's nominal flow rate;
+     * a program with a volume step for a zone without a known flow rate cannot be planned.
+     */
+    double volume;
+
+    bool operator==(const ZoneProgramStep& other) const {
+        return zone == other.zone && duration == other.duration && volume == other.volume;
+    }
+};
+
+/**
+ * @brief An ordered sequence of zone steps, executed one after the other, not before the start time.
+ */
+struct ZoneProgram {
+    time_point<system_clock> start;
+    std::vector<ZoneProgramStep> steps;
+
+    bool operator==(const ZoneProgram& other) const {
+        return start == other.start && steps == other.steps;
+    }
+};
+
+/**
+ * @brief A planned period during which a zone is open.
+ */
+struct ZoneRun {
+    size_t program;
+    size_t step;
+    size_t zone;
+    time_point<system_clock> start;
+    time_point<system_clock> end;
+};
+
+/**
+ * @brief Fits zone programs into the available irrigation windows under the hydraulic capacity of the supply line.
+ *
+ * Programs are planned greedily in order, every step as early as possible, while keeping the number
+ * of concurrently open zones and their summed nominal flow within the limits. A zone is never opened
+ * by two programs at the same time. Only programs are counted against the limits; zones opened
+ * by other means, e.g. by their own schedules, are not known to the planner.
+ *
+ * Because a program's plan depends only on the programs before it, changing a program only replans
+ * it and the programs after it.
+ */
+class ZoneProgramPlanner {
+public:
+    struct Window {
+        time_point<system_clock> start;
+        time_point<system_clock> end;
+
+        bool operator==(const Window& other) const {
+            return start == other.start && end == other.end;
+        }
+    };
+
+    /**
+     * @param maxConcurrentZones the maximum number of zones open at the same time, 0 means unlimited.
+     * @param maxFlow the maximum summed nominal flow of open zones in liters / min, 0 means unlimited.
+     */
+    ZoneProgramPlanner(size_t maxConcurrentZones = 0, double maxFlow = 0)
+        : maxConcurrentZones(maxConcurrentZones)
+        , maxFlow(maxFlow) {
+    }
+
+    void setLimits(size_t maxConcurrentZones, double maxFlow) {
+        if (this->maxConcurrentZones == maxConcurrentZones && this->maxFlow == maxFlow) {
+            return;
+        }
+        this->maxConcurrentZones = maxConcurrentZones;
+        this->maxFlow = maxFlow;
+        replanFrom(0);
+    }
+
+    /**
+     * @brief Sets the nominal flow rate of each zone in liters / min.
+     */
+    void setZoneFlowRates(const std::vector<double>& zoneFlowRates) {
+        if (this->zoneFlowRates == zoneFlowRates) {
+            return;
+        }
+        this->zoneFlowRates = zoneFlowRates;
+        replanFrom(0);
+    }
+
+    /**
+     * @brief The nominal flow rate of the zone in liters / min, or zero if it is not known.
+     */
+    double getFlowRate(size_t zone) const {
+        return zone < zoneFlowRates.size() ? zoneFlowRates[zone] : 0;
+    }
+
+    /**
+     * @brief Sets the windows during which irrigation is allowed; no windows means no restriction.
+     */
+    void setWindows(std::vector<Window> windows) {
+        std::sort(windows.begin(), windows.end(), [](const Window& a, const Window& b) {
+            return a.start < b.start;
+        });
+        if (this->windows == windows) {
+            return;
+        }
+        this->windows = std::move(windows);
+        replanFrom(0);
+    }
+
+    /**
+     * @brief Sets the programs in order of priority, replanning only from the first program that changed.
+     */
+    void setPrograms(const std::vector<ZoneProgram>& programs) {
+        size_t firstChanged = 0;
+        while (firstChanged < programs.size()
+            && firstChanged < this->programs.size()
+            && programs[firstChanged] == this->programs[firstChanged]) {
+            firstChanged++;
+        }
+        if (firstChanged == programs.size() && firstChanged == this->programs.size()) {
+            lastReplanned = 0;
+            return;
+        }
+        unplanFrom(firstChanged);
+        this->programs = programs;
+        planFrom(firstChanged);
+    }
+
+    const std::vector<ZoneRun>& getRuns() const {
+        return runs;
+    }
+
+    /**
+     * @brief Whether all steps of the program could be fitted into the available windows.
+     */
+    bool isPlanned(size_t program) const {
+        return program < planned.size() && planned[program];
+    }
+
+    /**
+     * @brief Whether the step's duration is known, i.e. it has a duration, or a volume and its zone has a known flow rate.
+     */
+    bool hasKnownDuration(const ZoneProgramStep& step) const {
+        return step.duration > seconds::zero()
+            || step.volume <= 0
+            || getFlowRate(step.zone) > 0;
+    }
+
+    /**
+     * @brief The number of programs planned during the last update.
+     */
+    size_t getLastReplanned() const {
+        return lastReplanned;
+    }
+
+    bool isZoneActive(size_t zone, time_point<system_clock> time) const {
+        auto segment = segmentAt(time);
+        return segment != timeline.end() && (segment->zoneMask & zoneBit(zone)) != 0;
+    }
+
+    /**
+     * @brief The next time after the given time at which the set of open zones changes,
+     * or the maximum time point if there are no more changes.
+     */
+    time_point<system_clock> getNextChange(time_point<system_clock> time) const {
+        auto next = std::upper_bound(timeline.begin(), timeline.end(), time, [](const time_point<system_clock>& time, const Breakpoint& breakpoint) {
+            return time < breakpoint.time;
+        });
+        return next == timeline.end()
+            ? time_point<system_clock>::max()
+            : next->time;
+    }
+
+private:
+    /**
+     * @brief The load from this point in time until the next breakpoint.
+     */
+    struct Breakpoint {
+        time_point<system_clock> time;
+        size_t zones;
+        double flow;
+        uint64_t zoneMask;
+
+        bool hasSameLoad(const Breakpoint& other) const {
+            return zones == other.zones && zoneMask == other.zoneMask && std::abs(flow - other.flow) < 1e-9;
+        }
+    };
+
+    static uint64_t zoneBit(size_t zone) {
+        return zone < 64 ? (uint64_t) 1 << zone : 0;
+    }
+
+    seconds getDuration(const ZoneProgramStep& step) const {
+        if (step.duration > seconds::zero()) {
+            return step.duration;
+        }
+        double flowRate = getFlowRate(step.zone);
+        if (flowRate <= 0 || step.volume <= 0) {
+            return seconds::zero();
+        }
+        return seconds { (long) std::ceil(step.volume / flowRate * 60) };
+    }
+
+    void replanFrom(size_t program) {
+        unplanFrom(program);
+        planFrom(program);
+    }
+
+    void unplanFrom(size_t program) {
+        auto first = std::find_if(runs.begin(), runs.end(), [program](const ZoneRun& run) {
+            return run.program >= program;
+        });
+        for (auto run = first; run != runs.end(); ++run) {
+            addLoad(*run, -1);
+        }
+        runs.erase(first, runs.end());
+        if (planned.size() > program) {
+            planned.resize(program);
+        }
+        compact();
+    }
+
+    void planFrom(size_t first) {
+        planned.resize(programs.size(), false);
+        for (size_t program = first; program < programs.size(); program++) {
+            planned[program] = planProgram(program);
+        }
+        lastReplanned = programs.size() - std::min(first, programs.size());
+    }
+
+    bool planProgram(size_t program) {
+        size_t firstRun = runs.size();
+        auto time = programs[program].start;
+        auto& steps = programs[program].steps;
+        for (auto& step : steps) {
+            if (!hasKnownDuration(step)) {
+                return false;
+            }
+        }
+        for (size_t step = 0; step < steps.size(); step++) {
+            auto duration = getDuration(steps[step]);
+            if (duration <= seconds::zero()) {
+                continue;
+            }
+            time_point<system_clock> start;
+            if (!findStart(steps[step].zone, duration, time, start)) {
+                // Roll back the steps that have already been placed
+                for (size_t index = firstRun; index < runs.size(); index++) {
+                    addLoad(runs[index], -1);
+                }
+                runs.resize(firstRun);
+                compact();
+                return false;
+            }
+            ZoneRun run { program, step, steps[step].zone, start, start + duration };
+            addLoad(run, 1);
+            runs.push_back(run);
+            time = run.end;
+        }
+        return true;
+    }
+
+    bool findStart(size_t zone, seconds duration, time_point<system_clock> notBefore, time_point<system_clock>& start) const {
+        auto time = notBefore;
+        while (true) {
+            if (!windows.empty()) {
+                auto window = std::find_if(windows.begin(), windows.end(), [time](const Window& window) {
+                    return window.end > time;
+                });
+                if (window == windows.end()) {
+                    return false;
+                }
+                time = std::max(time, window->start);
+                if (time + duration > window->end) {
+                    auto next = window + 1;
+                    if (next == windows.end()) {
+                        return false;
+                    }
+                    time = next->start;
+                    continue;
+                }
+            }
+            time_point<system_clock> retryAt;
+            if (fits(zone, duration, time, retryAt)) {
+                start = time;
+                return true;
+            }
+            time = retryAt;
+        }
+    }
+
+    /**
+     * @brief Checks if the zone can be opened during the given period; if not, sets the earliest time worth retrying.
+     */
+    bool fits(size_t zone, seconds duration, time_point<system_clock> start, time_point<system_clock>& retryAt) const {
+        auto end = start + duration;
+        double flow = getFlowRate(zone);
+        auto segment = segmentAt(start);
+        if (segment == timeline.end()) {
+            segment = timeline.begin();
+        } else if (!canAdd(*segment, zone, flow)) {
+            retryAt = nextBreakpointTime(segment);
+            return false;
+        } else {
+            ++segment;
+        }
+        for (; segment != timeline.end() && segment->time < end; ++segment) {
+            if (!canAdd(*segment, zone, flow)) {
+                retryAt = nextBreakpointTime(segment);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool canAdd(const Breakpoint& load, size_t zone, double flow) const {
+        if ((load.zoneMask & zoneBit(zone)) != 0) {
+            return false;
+        }
+        if (maxConcurrentZones > 0 && load.zones + 1 > maxConcurrentZones) {
+            return false;
+        }
+        // A zone that exceeds the flow limit on its own can still run alone
+        if (maxFlow > 0 && load.zones > 0 && load.flow + flow > maxFlow + 1e-9) {
+            return false;
+        }
+        return true;
+    }
+
+    time_point<system_clock> nextBreakpointTime(std::vector<Breakpoint>::const_iterator segment) const {
+        ++segment;
+        // The load after the last breakpoint is always zero, so there always is a next breakpoint
+        return segment == timeline.end()
+            ? time_point<system_clock>::max()
+            : segment->time;
+    }
+
+    /**
+     * @brief The breakpoint describing the load at the given time, or end() if the time is before the first breakpoint.
+     */
+    std::vector<Breakpoint>::const_iterator segmentAt(time_point<system_clock> time) const {
+        auto next = std::upper_bound(timeline.begin(), timeline.end(), time, [](const time_point<system_clock>& time, const Breakpoint& breakpoint) {
+            return time < breakpoint.time;
+        });
+        return next == timeline.begin()
+            ? timeline.end()
+            : next - 1;
+    }
+
+    size_t ensureBreakpoint(time_point<system_clock> time) {
+        auto next = std::lower_bound(timeline.begin(), timeline.end(), time, [](const Breakpoint& breakpoint, const time_point<system_clock>& time) {
+            return breakpoint.time < time;
+        });
+        if (next != timeline.end() && next->time == time) {
+            return next - timeline.begin();
+        }
+        Breakpoint breakpoint = next == timeline.begin()
+            ? Breakpoint { time, 0, 0, 0 }
+            : Breakpoint { time, (next - 1)->zones, (next - 1)->flow, (next - 1)->zoneMask };
+        auto inserted = timeline.insert(next, breakpoint);
+        return inserted - timeline.begin();
+    }
+
+    void addLoad(const ZoneRun& run, int sign) {
+        size_t first = ensureBreakpoint(run.start);
+        size_t last = ensureBreakpoint(run.end);
+        double flow = getFlowRate(run.zone);
+        for (size_t index = first; index < last; index++) {
+            auto& breakpoint = timeline[index];
+            breakpoint.zones += sign;
+            breakpoint.flow = breakpoint.zones == 0 ? 0 : breakpoint.flow + sign * flow;
+            breakpoint.zoneMask ^= zoneBit(run.zone);
+        }
+    }
+
+    void compact() {
+        static const Breakpoint zero { time_point<system_clock>(), 0, 0, 0 };
+        auto last = std::unique(timeline.begin(), timeline.end(), [](const Breakpoint& previous, const Breakpoint& current) {
+            return current.hasSameLoad(previous);
+        });
+        timeline.erase(last, timeline.end());
+        if (!timeline.empty() && timeline.front().hasSameLoad(zero)) {
+            timeline.erase(timeline.begin());
+        }
+    }
+
+    size_t maxConcurrentZones;
+    double maxFlow;
+    std::vector<double> zoneFlowRates;
+    std::vector<Window> windows;
+    std::vector<ZoneProgram> programs;
+
+    std::vector<ZoneRun> runs;
+    std::vector<bool> planned;
+    std::vector<Breakpoint> timeline;
+    size_t lastReplanned = 0;
+};
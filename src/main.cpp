@@ -7,6 +7,7 @@
 FlowControlApp app;
 
 void setup() {
+    app.sampleBetweenUploads();
     app.begin();
 }
 
@@ -1,30 +1,149 @@
 #pragma once
 
-#include <DHTesp.h>
+#include <driver/gpio.h>
+#include <driver/rmt.h>
+#include <esp_timer.h>
 
 #include "../AbstractEnvironmentHandler.hpp"
+#include "../Dht.hpp"
 
 using namespace farmhub::client;
 
+const rmt_channel_t DHT_RMT_CHANNEL = RMT_CHANNEL_0;
+
+/**
+ * @brief The number of pulses that fit in the RMT channel's memory block, two per item.
+ */
+const size_t DHT_MAX_PULSES = 128;
+
+/**
+ * @brief The line staying high for this long ends the capture.
+ */
+const uint16_t DHT_IDLE_THRESHOLD_US = 200;
+
+/**
+ * @brief How long the sensor takes to send its response after the start signal: 160 µs preamble and 40 bits of at most 120 µs.
+ */
+const milliseconds DHT_RESPONSE_TIME { 10 };
+
+/**
+ * @brief Reads a DHT sensor without bit-banging.
+ *
+ * The start signal is ended by a timer, and the response is captured by the RMT peripheral,
+ * so interrupts stay enabled and no task waits for the sensor.
+ */
 class DhtHandler
     : public AbstractEnvironmentHandler {
 
 public:
-    DhtHandler() = default;
+    DhtHandler(TaskContainer& tasks, const Config& config)
+        : AbstractEnvironmentHandler(tasks, "DHT", config) {
+    }
+
+    void begin(gpio_num_t pin, DhtModel model) {
+        Serial.printf("Initializing DHT sensor type %d on pin %d\n", static_cast<int>(model), pin);
+        this->pin = pin;
+        this->model = model;
+
+        rmt_config_t rmtConfig = RMT_DEFAULT_CONFIG_RX(pin, DHT_RMT_CHANNEL);
+        // Count in microseconds
+        rmtConfig.clk_div = 80;
+        rmtConfig.rx_config.filter_en = true;
+        rmtConfig.rx_config.filter_ticks_thresh = 100;
+        rmtConfig.rx_config.idle_threshold = DHT_IDLE_THRESHOLD_US;
+        if (rmt_config(&rmtConfig) != ESP_OK
+            || rmt_driver_install(DHT_RMT_CHANNEL, DHT_MAX_PULSES * sizeof(rmt_item32_t), 0) != ESP_OK
+            || rmt_get_ringbuf_handle(DHT_RMT_CHANNEL, &ringbuffer) != ESP_OK) {
+            Serial.println("Failed to set up RMT for DHT sensor");
+            return;
+        }
+
+        // Drive the line via open drain, so that the RMT can listen on the same pin
+        gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+        gpio_set_direction(pin, GPIO_MODE_INPUT_OUTPUT_OD);
+        gpio_set_level(pin, 1);
 
-    void begin(gpio_num_t pin, DHTesp::DHT_MODEL_t type) {
-        Serial.printf("Initializing DHT sensor type %d on pin %d\n", type, pin);
-        dht.setup(pin, type);
-        enabled = true;
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = releaseLine;
+        timerArgs.arg = this;
+        timerArgs.name = "DHT";
+        if (esp_timer_create(&timerArgs, &releaseTimer) != ESP_OK) {
+            Serial.println("Failed to create DHT timer");
+            return;
+        }
+        beginSampling();
     }
 
 protected:
-    void populateTelemetryInternal(JsonObject& json) override {
-        auto data = dht.getTempAndHumidity();
-        json["temperature"] = data.temperature;
-        json["humidity"] = data.humidity;
+    bool initialize() override {
+        // Nothing to set up on the sensor, a missing sensor shows up as a missing response
+        return true;
+    }
+
+    microseconds startSampling() override {
+        // Drop anything captured since the last time, e.g. noise
+        size_t size;
+        void* stale;
+        while ((stale = xRingbufferReceive(ringbuffer, &size, 0)) != nullptr) {
+            vRingbufferReturnItem(ringbuffer, stale);
+        }
+
+        // Pull the line low for the start signal; the timer releases it and starts the capture
+        milliseconds startSignal = model == DhtModel::DHT11
+            ? milliseconds { 20 }
+            : milliseconds { 2 };
+        gpio_set_level(pin, 0);
+        esp_timer_start_once(releaseTimer, duration_cast<microseconds>(startSignal).count());
+        return startSignal + DHT_RESPONSE_TIME;
+    }
+
+    bool collectSample(JsonObject& json) override {
+        rmt_rx_stop(DHT_RMT_CHANNEL);
+        size_t size = 0;
+        auto items = static_cast<rmt_item32_t*>(xRingbufferReceive(ringbuffer, &size, 0));
+        if (items == nullptr) {
+            Serial.println("No response from DHT sensor");
+            return false;
+        }
+        DhtPulse pulses[DHT_MAX_PULSES];
+        size_t count = 0;
+        for (size_t i = 0; i < size / sizeof(rmt_item32_t) && count + 2 <= DHT_MAX_PULSES; i++) {
+            pulses[count++] = { static_cast<uint8_t>(items[i].level0), static_cast<uint16_t>(items[i].duration0) };
+            if (items[i].duration1 == 0) {
+                break;
+            }
+            pulses[count++] = { static_cast<uint8_t>(items[i].level1), static_cast<uint16_t>(items[i].duration1) };
+        }
+        vRingbufferReturnItem(ringbuffer, items);
+
+        uint8_t data[DHT_FRAME_BITS / 8];
+        double temperature;
+        double humidity;
+        if (!Dht::decodeFrame(pulses, count, data)) {
+            Serial.printf("Incomplete response from DHT sensor, %d pulses\n", count);
+            return false;
+        }
+        if (!Dht::parseFrame(model, data, temperature, humidity)) {
+            Serial.println("Checksum error in DHT response");
+            return false;
+        }
+        json["temperature"] = temperature;
+        json["humidity"] = humidity;
+        return true;
     }
 
 private:
-    DHTesp dht;
+    /**
+     * @brief Ends the start signal and starts capturing the response; called from the timer task.
+     */
+    static void releaseLine(void* arg) {
+        auto handler = static_cast<DhtHandler*>(arg);
+        gpio_set_level(handler->pin, 1);
+        rmt_rx_start(DHT_RMT_CHANNEL, true);
+    }
+
+    gpio_num_t pin;
+    DhtModel model;
+    RingbufHandle_t ringbuffer = nullptr;
+    esp_timer_handle_t releaseTimer = nullptr;
 };
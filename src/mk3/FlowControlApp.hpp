@@ -38,11 +38,11 @@ public:
         }
     }
 
-    DHTesp::DHT_MODEL_t getDhtType() {
+    DhtModel getDhtType() {
         if (model.get() == "mk1") {
-            return DHTesp::DHT_MODEL_t::DHT11;
+            return DhtModel::DHT11;
         } else {
-            return DHTesp::DHT_MODEL_t::AM2302;
+            return DhtModel::AM2302;
         }
     }
 
@@ -57,6 +57,13 @@ public:
         return milliseconds { 250 };
     }
 
+    /**
+     * @brief The current drawn by the relays and the valve coil during a pulse, in mA.
+     */
+    uint32_t getValvePeakCurrent() {
+        return 400;
+    }
+
     bool isModeSwitchPresent() {
         return model.get() != "mk0" && model.get() != "mk4";
     }
@@ -69,10 +76,11 @@ public:
 class FlowControlApp : public AbstractFlowControlApp {
 public:
     FlowControlApp()
-        : AbstractFlowControlApp(deviceConfig, valveController) {
-        telemetryPublisher.registerProvider(environment);
-        telemetryPublisher.registerProvider(valve);
-        telemetryPublisher.registerProvider(mode);
+        : AbstractFlowControlApp(deviceConfig, { &valveController }) {
+        registerTelemetryProvider("environment", environment);
+        registerTelemetryProvider("mode", mode);
+        journal.registerProvider(environment);
+        journal.registerProvider(mode);
     }
 
     void beginPeripherials() override {
@@ -89,9 +97,26 @@ public:
         }
     }
 
+protected:
+    void sampleSensors(JsonObject& json, uint32_t sensorConfig) override {
+        if (sensorConfig != 0) {
+            environment.begin(DHT_PIN, static_cast<DhtModel>(sensorConfig));
+            environment.sampleNow(json);
+        }
+    }
+
+    /**
+     * @brief The DHT model, or 0 if there is no environment sensor.
+     */
+    uint32_t getSensorConfig() override {
+        return deviceConfig.isEnvironmentSensorPresent()
+            ? static_cast<uint32_t>(deviceConfig.getDhtType())
+            : 0;
+    }
+
 private:
     FlowControlDeviceConfig deviceConfig;
-    DhtHandler environment;
-    RelayValveController valveController { deviceConfig.getValvePulseDuration() };
+    DhtHandler environment { tasks, config.environment };
+    RelayValveController valveController { deviceConfig.getValvePulseDuration(), deviceConfig.getValvePeakCurrent() };
     ModeHandler mode { tasks, sleep, valve };
 };
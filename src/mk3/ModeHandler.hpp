@@ -4,17 +4,21 @@
 #include <Task.hpp>
 #include <Telemetry.hpp>
 
+#include "../ProfiledTask.hpp"
+#include "../TelemetrySnapshotProvider.hpp"
+#include "../Tracer.hpp"
 #include "ValveHandler.hpp"
 
 using namespace farmhub::client;
 
 /**
- * @brief Handles the physical "mode" switch that can manually force the valve to open or close in an emergency.
+ * @brief Handles the physical "mode" switch that can manually force the valves to open or close in an emergency.
  */
 class ModeHandler
-    : public BaseTask,
+    : public ProfiledTask,
       public BaseSleepListener,
-      public TelemetryProvider {
+      public TelemetryProvider,
+      public TelemetrySnapshotProvider {
 public:
     enum class Mode {
         /**
@@ -39,7 +43,7 @@ public:
     };
 
     ModeHandler(TaskContainer& tasks, SleepHandler& sleep, ValveHandler& valveHandler)
-        : BaseTask(tasks, "Mode handler")
+        : ProfiledTask(tasks, "Mode handler")
         , BaseSleepListener(sleep)
         , valveHandler(valveHandler) {
     }
@@ -59,9 +63,14 @@ public:
         if (!enabled) {
             return;
         }
+        TRACE_SCOPE("mode/telemetry");
         json["mode"] = static_cast<int>(mode);
     }
 
+    void populateSnapshot(JsonObject& json) override {
+        populateTelemetry(json);
+    }
+
 protected:
     void onWake(WakeEvent& event) override {
         if (!enabled) {
@@ -72,15 +81,20 @@ protected:
             setValveStateBasedOnMode(currentMode);
         } else {
             mode = currentMode;
+            if (mode == Mode::AUTO) {
+                // The switch may have been turned back while we were asleep
+                valveHandler.resumeAll(OverrideSource::MODE_SWITCH);
+            }
         }
     }
 
     const Schedule loop(const Timing& timing) override {
+        PROFILE_LOOP();
         if (!enabled) {
-            return sleepIndefinitely();
+            return profiledSleepIndefinitely();
         }
         setValveStateBasedOnMode(getSwitchState());
-        return sleepFor(seconds { 1 });
+        return profiledSleepFor(seconds { 1 });
     }
 
 private:
@@ -111,13 +125,14 @@ private:
             mode = currentMode;
             switch (mode) {
                 case Mode::OPEN:
-                    valveHandler.override(ValveHandler::State::OPEN, hours { 100 * 365 * 24 });
+                    valveHandler.overrideAll(ValveHandler::State::OPEN, hours { 100 * 365 * 24 }, OverrideSource::MODE_SWITCH);
                     break;
                 case Mode::CLOSED:
-                    valveHandler.override(ValveHandler::State::CLOSED, hours { 100 * 365 * 24 });
+                    valveHandler.overrideAll(ValveHandler::State::CLOSED, hours { 100 * 365 * 24 }, OverrideSource::MODE_SWITCH);
                     break;
                 case Mode::AUTO:
-                    // Do nothing, it will be handled by the valve handler
+                    // Hand the valves back to their schedules, keeping any remote overrides
+                    valveHandler.resumeAll(OverrideSource::MODE_SWITCH);
                     break;
                 default:
                     // We shouldn't be here
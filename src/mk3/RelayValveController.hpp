@@ -1,15 +1,26 @@
 #pragma once
 
+#include <esp_timer.h>
+
+#include "../PulseSequencer.hpp"
 #include "../ValveHandler.hpp"
 
 using namespace std::chrono;
 using namespace farmhub::client;
 
+/**
+ * @brief Drives a latching valve via two relays.
+ *
+ * Pulses are timed by a one-shot hardware timer, so {@link #open} and {@link #close}
+ * return immediately, and the end of the pulse is reported from the timer task.
+ * Commands issued during a pulse are queued and coalesced.
+ */
 class RelayValveController
     : public ValveController {
 public:
-    RelayValveController(milliseconds switchDuration)
-        : switchDuration(switchDuration) {
+    RelayValveController(milliseconds switchDuration, uint32_t peakCurrent)
+        : switchDuration(switchDuration)
+        , peakCurrent(peakCurrent) {
     }
 
     void begin(gpio_num_t openPin, gpio_num_t closePin) {
@@ -18,31 +29,95 @@ public:
         this->closePin = closePin;
         pinMode(openPin, OUTPUT);
         pinMode(closePin, OUTPUT);
+
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = &RelayValveController::onPulseTimer;
+        timerArgs.arg = this;
+        timerArgs.dispatch_method = ESP_TIMER_TASK;
+        timerArgs.name = "relay-pulse";
+        esp_timer_create(&timerArgs, &pulseTimer);
+
         reset();
     }
 
 protected:
     void open() override {
-        digitalWrite(openPin, LOW);
-        digitalWrite(closePin, HIGH);
-        delay(switchDuration.count());
-        reset();
+        request(PulseSequencer::Direction::OPEN, 1.0);
     }
 
     void close() override {
-        digitalWrite(openPin, HIGH);
-        digitalWrite(closePin, LOW);
-        delay(switchDuration.count());
-        reset();
+        request(PulseSequencer::Direction::CLOSE, 1.0);
+    }
+
+    void retry(bool open, double pulseScale) override {
+        request(open ? PulseSequencer::Direction::OPEN : PulseSequencer::Direction::CLOSE, pulseScale);
     }
 
     void reset() override {
+        portENTER_CRITICAL(&lock);
+        if (pulseTimer != nullptr) {
+            esp_timer_stop(pulseTimer);
+        }
+        sequencer.cancel();
+        release();
+        portEXIT_CRITICAL(&lock);
+    }
+
+    milliseconds getPeakDuration(bool open) override {
+        return switchDuration;
+    }
+
+    uint32_t getPeakCurrent() override {
+        return peakCurrent;
+    }
+
+private:
+    void request(PulseSequencer::Direction direction, double pulseScale) {
+        portENTER_CRITICAL(&lock);
+        auto next = sequencer.request(direction);
+        if (next != PulseSequencer::Direction::NONE) {
+            startPulse(next, pulseScale);
+        } else {
+            pendingPulseScale = pulseScale;
+        }
+        portEXIT_CRITICAL(&lock);
+    }
+
+    static void onPulseTimer(void* arg) {
+        static_cast<RelayValveController*>(arg)->finishPulse();
+    }
+
+    void finishPulse() {
+        portENTER_CRITICAL(&lock);
+        release();
+        bool opened = sequencer.getActive() == PulseSequencer::Direction::OPEN;
+        auto next = sequencer.complete();
+        if (next != PulseSequencer::Direction::NONE) {
+            startPulse(next, pendingPulseScale);
+        }
+        portEXIT_CRITICAL(&lock);
+        pulseCompleted(opened);
+    }
+
+    void startPulse(PulseSequencer::Direction direction, double pulseScale) {
+        bool opening = direction == PulseSequencer::Direction::OPEN;
+        digitalWrite(openPin, opening ? LOW : HIGH);
+        digitalWrite(closePin, opening ? HIGH : LOW);
+        esp_timer_start_once(pulseTimer, (uint64_t) (duration_cast<microseconds>(switchDuration).count() * pulseScale));
+    }
+
+    void release() {
         digitalWrite(openPin, HIGH);
         digitalWrite(closePin, HIGH);
     }
 
-private:
     const milliseconds switchDuration;
+    const uint32_t peakCurrent;
     gpio_num_t openPin;
     gpio_num_t closePin;
+
+    esp_timer_handle_t pulseTimer = nullptr;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    PulseSequencer sequencer;
+    double pendingPulseScale = 1.0;
 };
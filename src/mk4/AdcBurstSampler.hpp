@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+
+#include <Arduino.h>
+#include <driver/adc.h>
+
+/**
+ * @brief How long to wait for a burst to complete before giving up.
+ */
+const uint32_t ADC_BURST_TIMEOUT_MS = 100;
+
+/**
+ * @brief Takes bursts of samples from an ADC1 channel via the continuous (DMA) ADC driver.
+ *
+ * The ADC only runs for the duration of a burst, and the CPU is free while the samples are being collected.
+ */
+class AdcBurstSampler {
+public:
+    /**
+     * @param burstSize the number of samples in a burst.
+     * @param sampleFrequency the number of samples per second within a burst.
+     */
+    bool begin(gpio_num_t pin, size_t burstSize, uint32_t sampleFrequency) {
+        int channel = digitalPinToAnalogChannel(pin);
+        if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+            Serial.printf("Pin %d is not an ADC1 channel\n", pin);
+            return false;
+        }
+        this->channel = channel;
+        this->burstSize = burstSize;
+        burstBytes = burstSize * SOC_ADC_DIGI_RESULT_BYTES;
+
+        adc_digi_init_config_t initConfig = {};
+        initConfig.max_store_buf_size = burstBytes * 2;
+        initConfig.conv_num_each_intr = burstBytes;
+        initConfig.adc1_chan_mask = BIT(channel);
+        initConfig.adc2_chan_mask = 0;
+        if (adc_digi_initialize(&initConfig) != ESP_OK) {
+            Serial.println("Failed to initialize continuous ADC");
+            return false;
+        }
+
+        // Same attenuation as analogRead(), so that existing calibrations still apply
+        adc_digi_pattern_config_t pattern = {};
+        pattern.atten = ADC_ATTEN_DB_11;
+        pattern.channel = channel;
+        pattern.unit = 0;
+        pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+        adc_digi_configuration_t config = {};
+        config.conv_limit_en = true;
+        config.conv_limit_num = 250;
+        config.pattern_num = 1;
+        config.adc_pattern = &pattern;
+        config.sample_freq_hz = sampleFrequency;
+        config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+        config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+        if (adc_digi_controller_configure(&config) != ESP_OK) {
+            Serial.println("Failed to configure continuous ADC");
+            adc_digi_deinitialize();
+            return false;
+        }
+
+        buffer.resize(burstBytes);
+        return true;
+    }
+
+    /**
+     * @brief Takes a burst of raw samples with the digital controller's resolution.
+     *
+     * @return the number of samples read, at most the burst size.
+     */
+    size_t read(uint16_t* samples) {
+        size_t count = 0;
+        adc_digi_start();
+        while (count < burstSize) {
+            uint32_t length = 0;
+            if (adc_digi_read_bytes(buffer.data(), burstBytes, &length, ADC_BURST_TIMEOUT_MS) != ESP_OK) {
+                break;
+            }
+            for (uint32_t offset = 0; offset + SOC_ADC_DIGI_RESULT_BYTES <= length && count < burstSize; offset += SOC_ADC_DIGI_RESULT_BYTES) {
+                auto result = reinterpret_cast<adc_digi_output_data_t*>(&buffer[offset]);
+                if (result->type1.channel == channel) {
+                    samples[count++] = result->type1.data;
+                }
+            }
+        }
+        adc_digi_stop();
+        return count;
+    }
+
+private:
+    int channel;
+    size_t burstSize;
+    size_t burstBytes;
+    std::vector<uint8_t> buffer;
+};
@@ -15,8 +15,12 @@ enum class ValveControlStrategyType {
 
 class ValveControlStrategy {
 public:
-    virtual void open() = 0;
-    virtual void close() = 0;
+    /**
+     * @param pulseScale the factor to stretch the peak phase of the drive pulse by.
+     */
+    virtual void open(double pulseScale) = 0;
+    virtual void close(double pulseScale) = 0;
+    virtual milliseconds getPeakDuration(bool open) = 0;
     virtual String describe() = 0;
 };
 
@@ -40,6 +44,11 @@ public:
         Property<ValveControlStrategyType> strategy { this, "strategy", ValveControlStrategyType::NormallyClosed };
         Property<milliseconds> switchDuration { this, "switchDuration", milliseconds { 500 } };
         Property<double> holdDuty { this, "holdDuty", 0.5 };
+
+        /**
+         * @brief The current drawn by the valve while switching, in mA.
+         */
+        Property<uint32_t> peakCurrent { this, "peakCurrent", 500 };
     };
 
     class HoldingValveControlStrategy
@@ -53,9 +62,9 @@ public:
         }
 
     protected:
-        void driveAndHold(bool phase) {
+        void driveAndHold(bool phase, double pulseScale) {
             controller.drive(phase, 1.0);
-            delay(switchDuration.count());
+            delay(switchDuration.count() * pulseScale);
             controller.drive(phase, holdDuty);
         }
 
@@ -71,12 +80,15 @@ public:
             : HoldingValveControlStrategy(controller, switchDuration, holdDuty) {
         }
 
-        void open() override {
-            driveAndHold(HIGH);
+        void open(double pulseScale) override {
+            driveAndHold(HIGH, pulseScale);
         }
-        void close() override {
+        void close(double pulseScale) override {
             controller.stop();
         }
+        milliseconds getPeakDuration(bool open) override {
+            return open ? switchDuration : milliseconds::zero();
+        }
         String describe() override {
             return "normally closed with switch duration " + String((int) switchDuration.count()) + "ms and hold duty " + String(holdDuty * 100) + "%";
         }
@@ -89,11 +101,14 @@ public:
             : HoldingValveControlStrategy(controller, switchDuration, holdDuty) {
         }
 
-        void open() override {
+        void open(double pulseScale) override {
             controller.stop();
         }
-        void close() override {
-            driveAndHold(LOW);
+        void close(double pulseScale) override {
+            driveAndHold(LOW, pulseScale);
+        }
+        milliseconds getPeakDuration(bool open) override {
+            return open ? milliseconds::zero() : switchDuration;
         }
         String describe() override {
             return "normally open with switch duration " + String((int) switchDuration.count()) + "ms and hold duty " + String(holdDuty * 100) + "%";
@@ -108,16 +123,19 @@ public:
             , switchDuration(switchDuration) {
         }
 
-        void open() override {
+        void open(double pulseScale) override {
             controller.drive(HIGH, 1.0);
-            delay(switchDuration.count());
+            delay(switchDuration.count() * pulseScale);
             controller.stop();
         }
-        void close() override {
+        void close(double pulseScale) override {
             controller.drive(LOW, 1.0);
-            delay(switchDuration.count());
+            delay(switchDuration.count() * pulseScale);
             controller.stop();
         }
+        milliseconds getPeakDuration(bool open) override {
+            return switchDuration;
+        }
         String describe() override {
             return "latching with switch duration " + String((int) switchDuration.count()) + "ms";
         }
@@ -168,17 +186,36 @@ public:
     }
 
     void open() override {
-        strategy->open();
+        strategy->open(1.0);
+        pulseCompleted(true);
     }
 
     void close() override {
-        strategy->close();
+        strategy->close(1.0);
+        pulseCompleted(false);
+    }
+
+    void retry(bool open, double pulseScale) override {
+        if (open) {
+            strategy->open(pulseScale);
+        } else {
+            strategy->close(pulseScale);
+        }
+        pulseCompleted(open);
     }
 
     void reset() override {
         stop();
     }
 
+    milliseconds getPeakDuration(bool open) override {
+        return strategy->getPeakDuration(open);
+    }
+
+    uint32_t getPeakCurrent() override {
+        return config.peakCurrent.get();
+    }
+
     void stop() {
         digitalWrite(sleepPin, LOW);
         digitalWrite(enablePin, LOW);
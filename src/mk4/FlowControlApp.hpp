@@ -28,20 +28,27 @@ public:
     }
 
     Drv8801ValveController::Config valve { this };
+    ShtHandler::Config sht { this };
+    SoilSensorHandler::Config soilSensor { this };
 };
 
 class FlowControlApp : public AbstractFlowControlApp {
 public:
     FlowControlApp()
-        : AbstractFlowControlApp(deviceConfig, valveController) {
-        telemetryPublisher.registerProvider(environment);
-        telemetryPublisher.registerProvider(soilSensor);
+        : AbstractFlowControlApp(deviceConfig, { &valveController }) {
+        registerTelemetryProvider("environment", environment);
+        registerTelemetryProvider("soil", soilSensor);
+        journal.registerProvider(environment);
+        journal.registerProvider(soilSensor);
     }
 
     void beginPeripherials() override {
         resetWifi.begin(GPIO_NUM_0, INPUT_PULLUP);
-        environment.begin();
-        soilSensor.begin(GPIO_NUM_7, GPIO_NUM_6);
+        environment.begin(deviceConfig.sht);
+        soilSensor.begin(GPIO_NUM_7, GPIO_NUM_6, deviceConfig.soilSensor.resolution.get());
+        soilSensor.setMoisturePower(
+            static_cast<gpio_num_t>(deviceConfig.soilSensor.moisturePowerPin.get()),
+            deviceConfig.soilSensor.moistureSettleTime.get());
         valveController.begin(
             GPIO_NUM_10,    // Enable
             GPIO_NUM_11,    // Phase
@@ -53,10 +60,33 @@ public:
         );
     }
 
+protected:
+    void sampleSensors(JsonObject& json, uint32_t sensorConfig) override {
+        environment.resume();
+        soilSensor.begin(GPIO_NUM_7, GPIO_NUM_6, sensorConfig & 0xFF);
+        soilSensor.setMoisturePower(
+            static_cast<gpio_num_t>(static_cast<int8_t>((sensorConfig >> 8) & 0xFF)),
+            milliseconds { sensorConfig >> 16 });
+        environment.sampleNow(json);
+        soilSensor.sampleNow(json);
+    }
+
+    /**
+     * @brief The resolution of the soil temperature probes in the lowest byte, the moisture power pin in the next one,
+     * and the moisture settle time in milliseconds in the upper half.
+     */
+    uint32_t getSensorConfig() override {
+        auto& soil = deviceConfig.soilSensor;
+        uint32_t settleTime = std::min(soil.moistureSettleTime.get().count(), (milliseconds::rep) 0xFFFF);
+        return (soil.resolution.get() & 0xFF)
+            | ((soil.moisturePowerPin.get() & 0xFF) << 8)
+            | (settleTime << 16);
+    }
+
 private:
     FlowControlDeviceConfig deviceConfig;
-    ShtHandler environment;
-    SoilSensorHandler soilSensor;
+    ShtHandler environment { tasks, config.environment };
+    SoilSensorHandler soilSensor { tasks, config.soil };
     Drv8801ValveController valveController { deviceConfig.valve };
     HeldButtonListener resetWifi { tasks, "Reset WIFI", seconds { 5 },
         [&]() {
@@ -2,48 +2,129 @@
 
 #include <Wire.h>
 
-#include <SHT31.h>
-
 #include "../AbstractEnvironmentHandler.hpp"
+#include "../Sht3x.hpp"
 
 using namespace farmhub::client;
 
+/**
+ * @brief Reads an SHT3x sensor in periodic mode.
+ *
+ * The sensor measures on its own at the configured rate, and we only fetch the latest measurement,
+ * so reads are short and never wait for a conversion.
+ */
 class ShtHandler
     : public AbstractEnvironmentHandler {
 
-    const int SHT31_ADDRESS = 0x44;
+    const uint8_t SHT31_ADDRESS = 0x44;
+    const uint32_t SHT31_BUS_FREQUENCY = 400000;
 
 public:
-    ShtHandler() = default;
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent)
+            : NamedConfigurationSection(parent, "sht") {
+        }
+
+        /**
+         * @brief Measurements per second: 0.5, 1, 2, 4 or 10.
+         */
+        Property<double> measurementRate { this, "measurementRate", 1.0 };
+
+        /**
+         * @brief Measure in accelerated response time mode at 4 Hz instead, ignoring the rate.
+         */
+        Property<bool> acceleratedResponse { this, "acceleratedResponse", false };
+    };
+
+    ShtHandler(TaskContainer& tasks, const AbstractEnvironmentHandler::Config& config)
+        : AbstractEnvironmentHandler(tasks, "SHT", config) {
+    }
 
-    void begin() {
+    void begin(const Config& shtConfig) {
         Serial.print("Initializing SHT sensor\n");
         Wire.begin();
+        Wire.setClock(SHT31_BUS_FREQUENCY);
 
-        if (sht.begin()) {
-            Wire.setClock(100000);
-            // only supported by SHT3x
-            sht.heatOff();
-            enabled = true;
-        } else {
-            Serial.printf("SHT.init(): failed, error: %x\n", sht.getError());
-            enabled = false;
+        periodicCommand = SHT3X_PERIODIC_ART;
+        double rate = 4;
+        if (!shtConfig.acceleratedResponse.get()) {
+            rate = shtConfig.measurementRate.get();
+            if (!Sht3x::getPeriodicCommand(rate, periodicCommand)) {
+                Serial.printf("Unsupported SHT measurement rate %f, using 1 per second\n", rate);
+                rate = 1;
+                Sht3x::getPeriodicCommand(rate, periodicCommand);
+            }
         }
+
+        Serial.printf("Measuring %f times per second\n", rate);
+        measurementPeriod = duration_cast<microseconds>(duration<double>(1 / rate));
+        beginSampling();
+    }
+
+    /**
+     * @brief Picks up the periodic measurements started before deep sleep, without reconfiguring the sensor.
+     */
+    void resume() {
+        Wire.begin();
+        Wire.setClock(SHT31_BUS_FREQUENCY);
+        firstMeasurement = boot_clock::now();
+        resumeSampling();
     }
 
 protected:
-    void populateTelemetryInternal(JsonObject& json) override {
-        if (!sht.read()) {
-            Serial.printf("SHT.read(): failed, error: %x\n", sht.getError());
-            return;
+    bool initialize() override {
+        // The sensor stays in periodic mode during deep sleep, stop it before reconfiguring
+        if (!sendCommand(SHT3X_BREAK)) {
+            return false;
+        }
+        delay(1);
+        sendCommand(SHT3X_HEATER_OFF);
+        if (!sendCommand(periodicCommand)) {
+            Serial.println("Failed to start periodic measurement on SHT sensor");
+            return false;
+        }
+        // The first measurement is available after one period, plus the duration of a high repeatability measurement
+        firstMeasurement = boot_clock::now() + measurementPeriod + milliseconds { 15 };
+        return true;
+    }
+
+    microseconds startSampling() override {
+        // The sensor measures on its own, but wait for the first measurement after startup
+        return std::max(duration_cast<microseconds>(firstMeasurement - boot_clock::now()), microseconds::zero());
+    }
+
+    bool collectSample(JsonObject& json) override {
+        uint8_t data[SHT3X_MEASUREMENT_SIZE];
+        if (!sendCommand(SHT3X_FETCH_DATA)
+            || Wire.requestFrom(SHT31_ADDRESS, static_cast<uint8_t>(SHT3X_MEASUREMENT_SIZE)) != SHT3X_MEASUREMENT_SIZE) {
+            Serial.println("Failed to fetch measurement from SHT sensor");
+            return false;
+        }
+        for (size_t i = 0; i < SHT3X_MEASUREMENT_SIZE; i++) {
+            data[i] = Wire.read();
+        }
+        double temperature;
+        double humidity;
+        if (!Sht3x::parseMeasurement(data, temperature, humidity)) {
+            Serial.println("Corrupted measurement from SHT sensor");
+            return false;
         }
-        auto temperature = sht.getTemperature();
-        auto humidity = sht.getHumidity();
         json["temperature"] = temperature;
         json["humidity"] = humidity;
+        return true;
     }
 
 private:
+    bool sendCommand(uint16_t command) {
+        Wire.beginTransmission(SHT31_ADDRESS);
+        Wire.write(command >> 8);
+        Wire.write(command & 0xFF);
+        return Wire.endTransmission() == 0;
+    }
 
-    SHT31 sht;
+    uint16_t periodicCommand;
+    microseconds measurementPeriod;
+    time_point<boot_clock> firstMeasurement;
 };
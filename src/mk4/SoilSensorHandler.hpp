@@ -1,78 +1,250 @@
 #pragma once
 
+#include <vector>
+
 #include <DallasTemperature.h>
 #include <OneWire.h>
 
 #include "../AbstractEnvironmentHandler.hpp"
+#include "../SampleFilter.hpp"
+#include "AdcBurstSampler.hpp"
 
 using namespace farmhub::client;
 
+/**
+ * @brief The number of samples taken of the moisture sensor for each reading.
+ */
+const size_t MOISTURE_BURST_SIZE = 64;
+
+const uint32_t MOISTURE_SAMPLE_FREQUENCY = 20000;
+
+/**
+ * @brief The moisture samples are reduced to the trimmed mean of the medians of windows of this size.
+ */
+const size_t MOISTURE_MEDIAN_WINDOW = 5;
+
+const double MOISTURE_TRIM_FRACTION = 0.2;
+
+/**
+ * @brief Bursts are sampled at 12 bits, while the moisture calibration is for the 13 bits of analogRead().
+ */
+const double MOISTURE_BURST_SCALE = 2.0;
+
+/**
+ * @brief Reads the soil moisture sensor and any number of DS18B20 soil temperature probes on a OneWire bus.
+ *
+ * All probes are converted at once with a single broadcast command, so acquisition takes one conversion period
+ * regardless of the number of probes. Each probe is reported as <code>soilTemperature_&lt;ROM address&gt;</code>;
+ * the first probe is also reported as <code>soilTemperature</code>.
+ *
+ * Moisture is sampled in a short burst via DMA, and reduced with a median-of-N and trimmed mean filter
+ * to reject the noise of capacitive probes. The moisture probe can optionally be powered via a GPIO only while
+ * sampling; it is switched on when the temperature conversion starts, so it settles while the conversion runs.
+ *
+ * The health of the sensor as a whole reflects the moisture channel. The temperature probes are tracked as
+ * a separate channel: when none of them can be read, they are backed off and re-enumerated on their own,
+ * while moisture keeps being sampled.
+ */
 class SoilSensorHandler
     : public AbstractEnvironmentHandler {
 
 public:
-    SoilSensorHandler() = default;
+    class Config
+        : public NamedConfigurationSection {
+    public:
+        Config(ConfigurationSection* parent)
+            : NamedConfigurationSection(parent, "soilSensor") {
+        }
 
-    void begin(gpio_num_t temperaturePin, gpio_num_t moisturePin) {
-        Serial.printf("Initializing DS18B20 soil temperature sensor on pin %d\n", temperaturePin);
-        oneWire.begin(temperaturePin);
+        /**
+         * @brief The resolution of the temperature probes in bits, 9 to 12; each extra bit doubles the conversion time.
+         */
+        Property<int> resolution { this, "resolution", 12 };
 
-        // locate devices on the bus
-        Serial.print("Locating devices...");
-        sensors.begin();
-        Serial.print("Found ");
-        Serial.print(sensors.getDeviceCount(), DEC);
-        Serial.println(" devices.");
-
-        // report parasite power requirements
-        Serial.print("Parasite power is: ");
-        if (sensors.isParasitePowerMode()) {
-            Serial.println("ON");
-        } else {
-            Serial.println("OFF");
-        }
+        /**
+         * @brief The GPIO that powers the moisture probe, -1 if it is powered all the time.
+         */
+        Property<int> moisturePowerPin { this, "moisturePowerPin", -1 };
 
-        DeviceAddress thermometer;
-        if (!sensors.getAddress(thermometer, 0)) {
-            Serial.println("Unable to find address for device");
-            enabled = false;
-            return;
-        }
+        /**
+         * @brief How long the moisture probe needs after being powered on to give stable readings.
+         */
+        Property<milliseconds> moistureSettleTime { this, "moistureSettleTime", milliseconds { 100 } };
+    };
 
-        // show the addresses we found on the bus
-        Serial.print("Device 0 Address: ");
-        printAddress(thermometer);
-        Serial.println();
+    SoilSensorHandler(TaskContainer& tasks, const AbstractEnvironmentHandler::Config& config)
+        : AbstractEnvironmentHandler(tasks, "Soil sensor", config) {
+    }
+
+    void begin(gpio_num_t temperaturePin, gpio_num_t moisturePin, uint8_t resolution) {
+        Serial.printf("Initializing DS18B20 soil temperature probes on pin %d\n", temperaturePin);
+        oneWire.begin(temperaturePin);
+
+        this->resolution = constrain(resolution, 9, 12);
 
         Serial.printf("Initializing soil moisture sensor on pin %d\n", moisturePin);
         this->moisturePin = moisturePin;
         pinMode(moisturePin, INPUT);
+        burstSampling = moistureSampler.begin(moisturePin, MOISTURE_BURST_SIZE, MOISTURE_SAMPLE_FREQUENCY);
+        if (!burstSampling) {
+            Serial.println("Falling back to single soil moisture samples");
+        }
 
-        enabled = true;
+        beginSampling();
+    }
+
+    /**
+     * @brief Powers the moisture probe via the given pin only while sampling; GPIO_NUM_NC to keep it powered all the time.
+     */
+    void setMoisturePower(gpio_num_t powerPin, milliseconds settleTime) {
+        moisturePowerPin = powerPin;
+        moistureSettleTime = settleTime;
+        if (powerPin != GPIO_NUM_NC) {
+            Serial.printf("Powering soil moisture sensor via pin %d while sampling, settle time %ld ms\n",
+                powerPin, (long) settleTime.count());
+            pinMode(powerPin, OUTPUT);
+            digitalWrite(powerPin, LOW);
+        }
     }
 
 protected:
-    void populateTelemetryInternal(JsonObject& json) override {
-        populateTemperature(json);
-        populateMoisture(json);
+    bool initialize() override {
+        if (!initializeProbes()) {
+            Serial.printf("Retrying soil temperature probes in %ld seconds\n",
+                (long) duration_cast<seconds>(SENSOR_INITIAL_BACKOFF).count());
+            temperatureHealth.markOffline(boot_clock::now());
+        }
+        // Moisture needs no initialization, and is sampled even without temperature probes
+        return true;
     }
 
-    void populateTemperature(JsonObject& json) {
-        if (!sensors.requestTemperaturesByIndex(0)) {
-            Serial.println("Failed to get temperature from DS18B20 sensor");
-            return;
+    /**
+     * @brief Enumerates the temperature probes, so that probes plugged in later are picked up on re-initialization.
+     *
+     * @return false if no probes were found.
+     */
+    bool initializeProbes() {
+        sensors.begin();
+        probes.clear();
+        for (uint8_t index = 0; index < sensors.getDeviceCount(); index++) {
+            Probe probe;
+            if (!sensors.getAddress(probe.address, index) || !sensors.validFamily(probe.address)) {
+                continue;
+            }
+            probe.key = "soilTemperature_" + formatAddress(probe.address);
+            Serial.printf("Found probe %s\n", probe.key.c_str());
+            probes.push_back(probe);
         }
-        float temperature = sensors.getTempCByIndex(0);
-        if (temperature == DEVICE_DISCONNECTED_C) {
-            Serial.println("Failed to get temperature from DS18B20 sensor");
-            return;
+        if (probes.empty()) {
+            Serial.println("No DS18B20 probes found");
+            return false;
         }
-        json["soilTemperature"] = temperature;
+
+        // Only written to the probes if it differs, as it is stored in their EEPROM
+        sensors.setResolution(resolution);
+
+        // Start conversions without waiting for them to complete
+        sensors.setWaitForConversion(false);
+        return true;
+    }
+
+    microseconds startSampling() override {
+        milliseconds conversionTime = milliseconds::zero();
+        samplingTemperature = isTemperatureAttemptDue();
+        if (samplingTemperature) {
+            // Broadcast to all probes on the bus
+            if (!sensors.requestTemperatures()) {
+                Serial.println("Failed to start temperature conversion on DS18B20 probes");
+            }
+            conversionTime = milliseconds { sensors.millisToWaitForConversion(resolution) };
+        }
+        if (moisturePowerPin == GPIO_NUM_NC) {
+            return conversionTime;
+        }
+        digitalWrite(moisturePowerPin, HIGH);
+        return std::max(conversionTime, moistureSettleTime);
+    }
+
+    bool collectSample(JsonObject& json) override {
+        if (samplingTemperature) {
+            if (populateTemperature(json)) {
+                temperatureHealth.recordSuccess();
+            } else {
+                temperatureHealth.recordFailure(boot_clock::now());
+                if (temperatureHealth.needsReinit()) {
+                    Serial.printf("Soil temperature probes are offline, retrying in %ld seconds\n",
+                        (long) duration_cast<seconds>(temperatureHealth.getBackoff()).count());
+                }
+            }
+        }
+        bool success = populateMoisture(json);
+        if (moisturePowerPin != GPIO_NUM_NC) {
+            digitalWrite(moisturePowerPin, LOW);
+        }
+        return success;
+    }
+
+    void populateChannelHealth(JsonObject& healthsJson) override {
+        populateHealth(healthsJson, "Soil temperature", temperatureHealth);
     }
 
-    void populateMoisture(JsonObject& json) {
-        uint16_t soilMoistureValue = analogRead(moisturePin);
-        Serial.printf("Soil moisture value: %d\n", soilMoistureValue);
+    /**
+     * @brief Whether to sample the temperature probes now; re-enumerates them first if they have been offline.
+     */
+    bool isTemperatureAttemptDue() {
+        auto now = boot_clock::now();
+        if (!temperatureHealth.isAttemptDue(now)) {
+            return false;
+        }
+        if (temperatureHealth.needsReinit()) {
+            Serial.println("Re-initializing soil temperature probes");
+            temperatureHealth.recordReinit();
+            if (!initializeProbes()) {
+                temperatureHealth.recordFailure(now);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @return false if none of the probes could be read.
+     */
+    bool populateTemperature(JsonObject& json) {
+        bool success = false;
+        for (size_t index = 0; index < probes.size(); index++) {
+            auto& probe = probes[index];
+            float temperature = sensors.getTempC(probe.address);
+            if (temperature == DEVICE_DISCONNECTED_C) {
+                Serial.printf("Failed to get temperature from probe %s\n", probe.key.c_str());
+                continue;
+            }
+            json[probe.key] = temperature;
+            if (index == 0) {
+                json["soilTemperature"] = temperature;
+            }
+            success = true;
+        }
+        return success;
+    }
+
+    /**
+     * @return false if the moisture sensor could not be sampled.
+     */
+    bool populateMoisture(JsonObject& json) {
+        double soilMoistureValue;
+        if (burstSampling) {
+            size_t count = moistureSampler.read(moistureSamples);
+            if (count == 0) {
+                Serial.println("Failed to sample soil moisture");
+                return false;
+            }
+            soilMoistureValue = MOISTURE_BURST_SCALE
+                * SampleFilter::medianTrimmedMean(moistureSamples, count, MOISTURE_MEDIAN_WINDOW, MOISTURE_TRIM_FRACTION);
+        } else {
+            soilMoistureValue = analogRead(moisturePin);
+        }
+        Serial.printf("Soil moisture value: %f\n", soilMoistureValue);
 
         const double run = WaterValue - AirValue;
         const double rise = 100;
@@ -80,6 +252,7 @@ protected:
         double moisture = (delta * rise) / run;
 
         json["soilMoisture"] = moisture;
+        return true;
     }
 
 private:
@@ -89,16 +262,30 @@ private:
     // Pass our oneWire reference to Dallas Temperature.
     DallasTemperature sensors { &oneWire };
 
-    void printAddress(DeviceAddress deviceAddress) {
+    struct Probe {
+        DeviceAddress address;
+        String key;
+    };
+
+    static String formatAddress(const DeviceAddress address) {
+        char hex[17];
         for (uint8_t i = 0; i < 8; i++) {
-            // zero pad the address if necessary
-            if (deviceAddress[i] < 16)
-                Serial.print("0");
-            Serial.print(deviceAddress[i], HEX);
+            sprintf(hex + i * 2, "%02X", address[i]);
         }
+        return String(hex);
     }
 
+    std::vector<Probe> probes;
+    uint8_t resolution;
+    SensorHealth<boot_clock> temperatureHealth { SENSOR_FAILURES_BEFORE_OFFLINE, SENSOR_INITIAL_BACKOFF, SENSOR_MAX_BACKOFF };
+    bool samplingTemperature = false;
+
     const int AirValue = 8191;
     const int WaterValue = 3800;
     gpio_num_t moisturePin;
+    AdcBurstSampler moistureSampler;
+    bool burstSampling = false;
+    uint16_t moistureSamples[MOISTURE_BURST_SIZE];
+    gpio_num_t moisturePowerPin = GPIO_NUM_NC;
+    milliseconds moistureSettleTime;
 };
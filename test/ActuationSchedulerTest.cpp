@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "ActuationScheduler.hpp"
+
+using std::chrono::milliseconds;
+
+using Request = ActuationScheduler::Request;
+using Slot = ActuationScheduler::Slot;
+
+class ActuationSchedulerTest : public ::testing::Test {
+public:
+    ActuationSchedulerTest() = default;
+
+    std::vector<Slot> slots;
+};
+
+TEST_F(ActuationSchedulerTest, unlimited_budget_runs_everything_at_once) {
+    ActuationScheduler scheduler(0, 0);
+    EXPECT_EQ(scheduler.plan(slots, Request { 0, milliseconds { 500 }, 800 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 500 }, 800 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 500 }, 800 }).start, milliseconds { 0 });
+    EXPECT_EQ(ActuationScheduler::getMakespan(slots), milliseconds { 500 });
+}
+
+TEST_F(ActuationSchedulerTest, serializes_peaks_with_concurrency_of_one) {
+    ActuationScheduler scheduler(1, 0);
+    EXPECT_EQ(scheduler.plan(slots, Request { 0, milliseconds { 500 }, 800 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 250 }, 800 }).start, milliseconds { 500 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 500 }, 800 }).start, milliseconds { 750 });
+    EXPECT_EQ(ActuationScheduler::getMakespan(slots), milliseconds { 1250 });
+}
+
+TEST_F(ActuationSchedulerTest, staggers_peaks_with_concurrency_of_two) {
+    ActuationScheduler scheduler(2, 0);
+    EXPECT_EQ(scheduler.plan(slots, Request { 0, milliseconds { 500 }, 800 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 250 }, 800 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 500 }, 800 }).start, milliseconds { 250 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 3, milliseconds { 100 }, 800 }).start, milliseconds { 500 });
+    EXPECT_EQ(ActuationScheduler::getMakespan(slots), milliseconds { 750 });
+}
+
+TEST_F(ActuationSchedulerTest, respects_current_budget) {
+    ActuationScheduler scheduler(0, 1000);
+    EXPECT_EQ(scheduler.plan(slots, Request { 0, milliseconds { 500 }, 600 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 500 }, 300 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 500 }, 300 }).start, milliseconds { 500 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 3, milliseconds { 500 }, 100 }).start, milliseconds { 0 });
+}
+
+TEST_F(ActuationSchedulerTest, runs_request_over_current_budget_alone) {
+    ActuationScheduler scheduler(0, 500);
+    EXPECT_EQ(scheduler.plan(slots, Request { 0, milliseconds { 200 }, 300 }).start, milliseconds { 0 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 200 }, 800 }).start, milliseconds { 200 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 200 }, 300 }).start, milliseconds { 400 });
+}
+
+TEST_F(ActuationSchedulerTest, does_not_start_before_requested_time) {
+    ActuationScheduler scheduler(1, 0);
+    scheduler.plan(slots, Request { 0, milliseconds { 500 }, 800 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 100 }, 800 }, milliseconds { 700 }).start, milliseconds { 700 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 100 }, 800 }, milliseconds { 300 }).start, milliseconds { 500 });
+}
+
+TEST_F(ActuationSchedulerTest, does_not_start_into_a_later_peak) {
+    ActuationScheduler scheduler(1, 0);
+    scheduler.plan(slots, Request { 0, milliseconds { 100 }, 800 }, milliseconds { 200 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 250 }, 800 }).start, milliseconds { 300 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 2, milliseconds { 150 }, 800 }).start, milliseconds { 0 });
+}
+
+TEST_F(ActuationSchedulerTest, does_not_delay_requests_without_peak) {
+    ActuationScheduler scheduler(1, 0);
+    scheduler.plan(slots, Request { 0, milliseconds { 500 }, 800 });
+    EXPECT_EQ(scheduler.plan(slots, Request { 1, milliseconds { 0 }, 0 }).start, milliseconds { 0 });
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Counts heap allocations made via operator new since it was created.
+ *
+ * The global allocation operators are replaced in AllocationCounter.cpp, so this works for any code linked into the tests.
+ */
+class AllocationCounter {
+public:
+    AllocationCounter()
+        : start(getTotal()) {
+    }
+
+    size_t getCount() const {
+        return getTotal() - start;
+    }
+
+    /**
+     * @brief The number of allocations made since the program started.
+     */
+    static size_t getTotal();
+
+private:
+    const size_t start;
+};
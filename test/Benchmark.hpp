@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief Times code in benchmarks.
+ *
+ * Benchmarks are disabled via gtest's <code>DISABLED_</code> prefix, so that their timing output stays out of the unit test run.
+ * Run them with <code>pio test -e native -a --gtest_also_run_disabled_tests -a --gtest_filter=*Benchmark*</code>.
+ */
+class Benchmark {
+public:
+    /**
+     * @brief The average time a single call of the function takes, over the given number of calls.
+     */
+    template <typename Duration = std::chrono::microseconds, typename F>
+    static Duration measure(F f, size_t iterations = 1) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            f();
+        }
+        return std::chrono::duration_cast<Duration>(std::chrono::steady_clock::now() - start) / iterations;
+    }
+};
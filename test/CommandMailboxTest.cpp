@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "CommandMailbox.hpp"
+
+class CommandMailboxTest : public ::testing::Test {
+public:
+    CommandMailboxTest() = default;
+
+    CommandMailbox<int, 4> mailbox;
+};
+
+TEST_F(CommandMailboxTest, empty_by_default) {
+    int command;
+    EXPECT_TRUE(mailbox.isEmpty());
+    EXPECT_FALSE(mailbox.take(command));
+}
+
+TEST_F(CommandMailboxTest, delivers_in_order) {
+    EXPECT_TRUE(mailbox.post(1));
+    EXPECT_TRUE(mailbox.post(2));
+    EXPECT_FALSE(mailbox.isEmpty());
+
+    int command;
+    EXPECT_TRUE(mailbox.take(command));
+    EXPECT_EQ(command, 1);
+    EXPECT_TRUE(mailbox.take(command));
+    EXPECT_EQ(command, 2);
+    EXPECT_FALSE(mailbox.take(command));
+    EXPECT_TRUE(mailbox.isEmpty());
+}
+
+TEST_F(CommandMailboxTest, rejects_when_full) {
+    EXPECT_TRUE(mailbox.post(1));
+    EXPECT_TRUE(mailbox.post(2));
+    EXPECT_TRUE(mailbox.post(3));
+    EXPECT_FALSE(mailbox.post(4));
+
+    int command;
+    EXPECT_TRUE(mailbox.take(command));
+    EXPECT_EQ(command, 1);
+    EXPECT_TRUE(mailbox.post(4));
+}
+
+TEST_F(CommandMailboxTest, wraps_around) {
+    int command;
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(mailbox.post(i));
+        EXPECT_TRUE(mailbox.take(command));
+        EXPECT_EQ(command, i);
+    }
+    EXPECT_TRUE(mailbox.isEmpty());
+}
+
+TEST_F(CommandMailboxTest, transfers_between_threads) {
+    const int count = 100000;
+    CommandMailbox<int, 16> shared;
+    std::thread producer([&]() {
+        for (int i = 0; i < count; i++) {
+            while (!shared.post(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    while (expected < count) {
+        int command;
+        if (shared.take(command)) {
+            ASSERT_EQ(command, expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(shared.isEmpty());
+}
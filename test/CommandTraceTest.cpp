@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "CommandMailbox.hpp"
+#include "CommandTrace.hpp"
+
+using std::chrono::seconds;
+
+class CommandTraceTest : public ::testing::Test {
+public:
+    const time_point<system_clock> base { system_clock::from_time_t(1577836800) };
+};
+
+TEST_F(CommandTraceTest, default_trace_is_inactive) {
+    CommandTrace trace {};
+    EXPECT_FALSE(trace.isActive());
+    EXPECT_FALSE(trace.hasCorrelationId());
+}
+
+TEST_F(CommandTraceTest, records_receive_time_in_microseconds) {
+    auto trace = CommandTrace::receive("abc-123", 1577836799500, base + microseconds { 250 });
+    EXPECT_TRUE(trace.isActive());
+    EXPECT_STREQ(trace.correlationId, "abc-123");
+    EXPECT_EQ(trace.clientTime, 1577836799500);
+    EXPECT_EQ(trace.received, 1577836800000250);
+    EXPECT_EQ(trace.dequeued, 0);
+    EXPECT_EQ(trace.actuationStarted, 0);
+    EXPECT_EQ(trace.actuationCompleted, 0);
+}
+
+TEST_F(CommandTraceTest, correlation_id_is_optional) {
+    auto trace = CommandTrace::receive(nullptr, 0, base);
+    EXPECT_TRUE(trace.isActive());
+    EXPECT_FALSE(trace.hasCorrelationId());
+}
+
+TEST_F(CommandTraceTest, truncates_long_correlation_id) {
+    auto trace = CommandTrace::receive("0123456789012345678901234567890123456789", 0, base);
+    EXPECT_STREQ(trace.correlationId, "012345678901234567890123456789012345");
+}
+
+TEST_F(CommandTraceTest, survives_mailbox) {
+    CommandMailbox<CommandTrace, 2> mailbox;
+    mailbox.post(CommandTrace::receive("abc-123", 42, base));
+    CommandTrace trace;
+    ASSERT_TRUE(mailbox.take(trace));
+    EXPECT_STREQ(trace.correlationId, "abc-123");
+    EXPECT_EQ(trace.clientTime, 42);
+    EXPECT_EQ(trace.received, CommandTrace::toMicros(base));
+}
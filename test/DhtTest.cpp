@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "Dht.hpp"
+
+class DhtTest : public ::testing::Test {
+public:
+    /**
+     * @brief Simulates the response of a sensor sending the given bytes.
+     */
+    static std::vector<DhtPulse> respond(const std::vector<uint8_t>& bytes) {
+        std::vector<DhtPulse> pulses;
+        // The line is released by the host before the sensor responds
+        pulses.push_back({ 1, 30 });
+        pulses.push_back({ 0, 80 });
+        pulses.push_back({ 1, 80 });
+        for (auto byte : bytes) {
+            for (int bit = 7; bit >= 0; bit--) {
+                pulses.push_back({ 0, 50 });
+                pulses.push_back({ 1, static_cast<uint16_t>((byte >> bit) & 1 ? 70 : 27) });
+            }
+        }
+        pulses.push_back({ 0, 50 });
+        return pulses;
+    }
+
+    static std::vector<uint8_t> withChecksum(std::vector<uint8_t> bytes) {
+        bytes.push_back(static_cast<uint8_t>(bytes[0] + bytes[1] + bytes[2] + bytes[3]));
+        return bytes;
+    }
+
+    uint8_t data[5];
+    double temperature;
+    double humidity;
+};
+
+TEST_F(DhtTest, decodes_dht22_frame) {
+    // 65.2 %RH, -10.1 °C
+    auto pulses = respond(withChecksum({ 0x02, 0x8C, 0x80, 0x65 }));
+    ASSERT_TRUE(Dht::decodeFrame(pulses.data(), pulses.size(), data));
+    ASSERT_TRUE(Dht::parseFrame(DhtModel::DHT22, data, temperature, humidity));
+    EXPECT_NEAR(humidity, 65.2, 1e-9);
+    EXPECT_NEAR(temperature, -10.1, 1e-9);
+}
+
+TEST_F(DhtTest, decodes_dht11_frame) {
+    // 45.0 %RH, 23.5 °C
+    auto pulses = respond(withChecksum({ 45, 0, 23, 5 }));
+    ASSERT_TRUE(Dht::decodeFrame(pulses.data(), pulses.size(), data));
+    ASSERT_TRUE(Dht::parseFrame(DhtModel::DHT11, data, temperature, humidity));
+    EXPECT_NEAR(humidity, 45.0, 1e-9);
+    EXPECT_NEAR(temperature, 23.5, 1e-9);
+}
+
+TEST_F(DhtTest, decodes_capture_starting_with_response) {
+    auto pulses = respond(withChecksum({ 0x01, 0xF4, 0x00, 0xFA }));
+    pulses.erase(pulses.begin());
+    ASSERT_TRUE(Dht::decodeFrame(pulses.data(), pulses.size(), data));
+    ASSERT_TRUE(Dht::parseFrame(DhtModel::AM2302, data, temperature, humidity));
+    EXPECT_NEAR(humidity, 50.0, 1e-9);
+    EXPECT_NEAR(temperature, 25.0, 1e-9);
+}
+
+TEST_F(DhtTest, rejects_truncated_capture) {
+    auto pulses = respond(withChecksum({ 0x02, 0x8C, 0x80, 0x65 }));
+    pulses.resize(pulses.size() - 10);
+    EXPECT_FALSE(Dht::decodeFrame(pulses.data(), pulses.size(), data));
+}
+
+TEST_F(DhtTest, rejects_bad_checksum) {
+    auto bytes = withChecksum({ 0x02, 0x8C, 0x80, 0x65 });
+    bytes[4] ^= 0x01;
+    auto pulses = respond(bytes);
+    ASSERT_TRUE(Dht::decodeFrame(pulses.data(), pulses.size(), data));
+    EXPECT_FALSE(Dht::parseFrame(DhtModel::DHT22, data, temperature, humidity));
+}
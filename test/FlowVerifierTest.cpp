@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "FlowVerifier.hpp"
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::chrono::time_point;
+
+using Result = FlowVerifier<steady_clock>::Result;
+
+class FlowVerifierTest : public ::testing::Test {
+public:
+    FlowVerifierTest() = default;
+
+    const time_point<steady_clock> base { steady_clock::now() };
+    const time_point<steady_clock> longAgo { base - seconds { 600 } };
+    FlowVerifier<steady_clock> verifier { seconds { 10 }, seconds { 2 }, 3, 2.0 };
+};
+
+TEST_F(FlowVerifierTest, idle_until_started) {
+    EXPECT_FALSE(verifier.isActive());
+    EXPECT_EQ(verifier.update(base, longAgo), Result::IDLE);
+}
+
+TEST_F(FlowVerifierTest, verifies_flow_start) {
+    verifier.start(true, base);
+    EXPECT_EQ(verifier.update(base + seconds { 1 }, longAgo), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 3 }, base + milliseconds { 2500 }), Result::VERIFIED);
+    EXPECT_EQ(verifier.getLatency(), milliseconds { 2500 });
+    EXPECT_EQ(verifier.getAttempts(), 1);
+    EXPECT_FALSE(verifier.isActive());
+}
+
+TEST_F(FlowVerifierTest, verifies_flow_stop) {
+    verifier.start(false, base);
+    EXPECT_EQ(verifier.update(base + seconds { 1 }, base + milliseconds { 500 }), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 2 }, base + milliseconds { 1000 }), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 3 }, base + milliseconds { 1000 }), Result::VERIFIED);
+    EXPECT_EQ(verifier.getLatency(), milliseconds { 1000 });
+}
+
+TEST_F(FlowVerifierTest, verifies_flow_stop_immediately_when_there_was_no_flow) {
+    verifier.start(false, base);
+    EXPECT_EQ(verifier.update(base, longAgo), Result::VERIFIED);
+    EXPECT_EQ(verifier.getLatency(), milliseconds::zero());
+}
+
+TEST_F(FlowVerifierTest, retries_with_escalating_pulse) {
+    verifier.start(true, base);
+    EXPECT_EQ(verifier.update(base + seconds { 9 }, longAgo), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 10 }, longAgo), Result::RETRY);
+    EXPECT_EQ(verifier.getAttempts(), 2);
+    EXPECT_DOUBLE_EQ(verifier.getPulseScale(), 2.0);
+    EXPECT_EQ(verifier.update(base + seconds { 19 }, longAgo), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 20 }, longAgo), Result::RETRY);
+    EXPECT_EQ(verifier.getAttempts(), 3);
+    EXPECT_DOUBLE_EQ(verifier.getPulseScale(), 4.0);
+    EXPECT_EQ(verifier.update(base + seconds { 25 }, base + seconds { 24 }), Result::VERIFIED);
+    EXPECT_EQ(verifier.getLatency(), seconds { 24 });
+}
+
+TEST_F(FlowVerifierTest, fails_after_max_attempts) {
+    verifier.start(true, base);
+    EXPECT_EQ(verifier.update(base + seconds { 10 }, longAgo), Result::RETRY);
+    EXPECT_EQ(verifier.update(base + seconds { 20 }, longAgo), Result::RETRY);
+    EXPECT_EQ(verifier.update(base + seconds { 30 }, longAgo), Result::FAILED);
+    EXPECT_EQ(verifier.getLatency(), seconds { 30 });
+    EXPECT_FALSE(verifier.isActive());
+    EXPECT_EQ(verifier.update(base + seconds { 40 }, longAgo), Result::IDLE);
+}
+
+TEST_F(FlowVerifierTest, reports_deadline) {
+    EXPECT_EQ(verifier.getDeadline(longAgo), time_point<steady_clock>::max());
+    verifier.start(true, base);
+    EXPECT_EQ(verifier.getDeadline(longAgo), base + seconds { 10 });
+    EXPECT_EQ(verifier.update(base + seconds { 10 }, longAgo), Result::RETRY);
+    EXPECT_EQ(verifier.getDeadline(longAgo), base + seconds { 20 });
+
+    verifier.start(false, base);
+    EXPECT_EQ(verifier.getDeadline(base + seconds { 1 }), base + seconds { 3 });
+    EXPECT_EQ(verifier.getDeadline(base + seconds { 9 }), base + seconds { 10 });
+}
+
+TEST_F(FlowVerifierTest, verifies_flow_rate_increase) {
+    verifier.startRateChange(10.0, 8.0, base);
+    EXPECT_TRUE(verifier.isExpectingFlow());
+    EXPECT_EQ(verifier.update(base + seconds { 1 }, base + seconds { 1 }, 12.0), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 2 }, base + seconds { 2 }, 16.0), Result::VERIFIED);
+    EXPECT_EQ(verifier.getLatency(), seconds { 2 });
+}
+
+TEST_F(FlowVerifierTest, verifies_flow_rate_decrease) {
+    verifier.startRateChange(18.0, -8.0, base);
+    EXPECT_FALSE(verifier.isExpectingFlow());
+    EXPECT_EQ(verifier.update(base + seconds { 1 }, base + seconds { 1 }, 18.0), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 2 }, base + seconds { 2 }, 11.0), Result::VERIFIED);
+}
+
+TEST_F(FlowVerifierTest, retries_when_flow_rate_changes_the_wrong_way) {
+    verifier.startRateChange(10.0, 8.0, base);
+    // Other zones keep flowing, so flow being seen is not enough
+    EXPECT_EQ(verifier.update(base + seconds { 5 }, base + seconds { 5 }, 6.0), Result::PENDING);
+    EXPECT_EQ(verifier.update(base + seconds { 10 }, base + seconds { 10 }, 10.0), Result::RETRY);
+    EXPECT_EQ(verifier.getPulseScale(), 2.0);
+}
+
+TEST_F(FlowVerifierTest, polls_flow_rate_change) {
+    verifier.startRateChange(10.0, 8.0, base);
+    EXPECT_EQ(verifier.getDeadline(longAgo), base + seconds { 1 });
+    EXPECT_EQ(verifier.update(base + seconds { 9 }, longAgo, 10.0), Result::PENDING);
+    EXPECT_EQ(verifier.getDeadline(longAgo), base + seconds { 10 });
+}
@@ -0,0 +1,127 @@
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.hpp"
+#include "CommandMailbox.hpp"
+#include "FlowVerifier.hpp"
+#include "LatencyStats.hpp"
+#include "RunningAggregate.hpp"
+#include "SampleFilter.hpp"
+#include "SensorHealth.hpp"
+#include "TaskProfile.hpp"
+#include "ValveScheduler.hpp"
+#include "ZoneProgramPlanner.hpp"
+
+using std::chrono::hours;
+using std::chrono::minutes;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+/**
+ * @brief Code that runs on every loop, sample or evaluation must not allocate, to keep the heap from fragmenting.
+ */
+class HotPathAllocationTest : public ::testing::Test {
+public:
+    HotPathAllocationTest() = default;
+
+    const time_point<system_clock> base { system_clock::from_time_t(1577836800) };
+};
+
+TEST_F(HotPathAllocationTest, allocation_counter_counts_allocations) {
+    AllocationCounter counter;
+    std::unique_ptr<int> value(new int(42));
+    std::vector<int> values(10);
+    EXPECT_EQ(counter.getCount(), 2);
+}
+
+TEST_F(HotPathAllocationTest, schedule_evaluation_does_not_allocate) {
+    ValveScheduler scheduler;
+    std::list<ValveSchedule> schedules;
+    schedules.emplace_back(base, hours { 24 }, minutes { 15 });
+    schedules.emplace_back(base + hours { 12 }, hours { 24 }, minutes { 30 });
+
+    AllocationCounter counter;
+    for (int hour = 0; hour < 48; hour++) {
+        auto time = base + hours { hour };
+        scheduler.isScheduled(schedules, time);
+        scheduler.getNextChange(schedules, time);
+    }
+    EXPECT_EQ(counter.getCount(), 0);
+}
+
+TEST_F(HotPathAllocationTest, program_lookup_does_not_allocate) {
+    ZoneProgramPlanner planner;
+    planner.setPrograms({
+        ZoneProgram { base, { ZoneProgramStep { 0, minutes { 10 }, 0 }, ZoneProgramStep { 1, minutes { 5 }, 0 } } },
+    });
+
+    AllocationCounter counter;
+    for (int minute = 0; minute < 30; minute++) {
+        auto time = base + minutes { minute };
+        planner.isZoneActive(0, time);
+        planner.isZoneActive(1, time);
+        planner.getNextChange(time);
+    }
+    EXPECT_EQ(counter.getCount(), 0);
+}
+
+TEST_F(HotPathAllocationTest, commands_do_not_allocate) {
+    CommandMailbox<int, 4> mailbox;
+
+    AllocationCounter counter;
+    for (int i = 0; i < 10; i++) {
+        int command;
+        mailbox.post(i);
+        mailbox.take(command);
+    }
+    EXPECT_EQ(counter.getCount(), 0);
+}
+
+TEST_F(HotPathAllocationTest, flow_verification_does_not_allocate) {
+    auto now = steady_clock::now();
+    FlowVerifier<steady_clock> verifier { seconds { 10 }, seconds { 2 }, 3, 2.0 };
+
+    AllocationCounter counter;
+    verifier.start(true, now);
+    for (int second = 0; second < 60; second++) {
+        verifier.update(now + seconds { second }, now - seconds { 600 });
+        verifier.getDeadline(now - seconds { 600 });
+    }
+    EXPECT_EQ(counter.getCount(), 0);
+}
+
+TEST_F(HotPathAllocationTest, sampling_does_not_allocate) {
+    RunningAggregate aggregate;
+    SensorHealth<steady_clock> health { 3, seconds { 30 }, hours { 1 } };
+    uint16_t samples[64];
+
+    AllocationCounter counter;
+    for (int i = 0; i < 100; i++) {
+        for (size_t j = 0; j < 64; j++) {
+            samples[j] = static_cast<uint16_t>((i * 31 + j * 17) % 4096);
+        }
+        aggregate.add(SampleFilter::medianTrimmedMean(samples, 64, 5, 0.2));
+        if (i % 10 == 0) {
+            health.recordFailure(steady_clock::now());
+        } else {
+            health.recordSuccess();
+        }
+    }
+    EXPECT_EQ(counter.getCount(), 0);
+}
+
+TEST_F(HotPathAllocationTest, diagnostics_do_not_allocate) {
+    TaskProfile profile { "test" };
+    LatencyStats stats;
+
+    AllocationCounter counter;
+    for (int i = 0; i < 100; i++) {
+        profile.recordLoop(microseconds { i * 100 });
+        profile.recordSleep(seconds { 1 });
+        stats.record(microseconds { i * 100 });
+    }
+    EXPECT_EQ(counter.getCount(), 0);
+}
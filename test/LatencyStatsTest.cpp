@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include "LatencyStats.hpp"
+
+using std::chrono::milliseconds;
+
+class LatencyStatsTest : public ::testing::Test {
+public:
+    LatencyStats stats;
+};
+
+TEST_F(LatencyStatsTest, empty_stats) {
+    EXPECT_EQ(stats.getCount(), 0);
+    EXPECT_EQ(stats.getLast(), microseconds::zero());
+    EXPECT_EQ(stats.getMax(), microseconds::zero());
+    EXPECT_EQ(stats.getAverage(), microseconds::zero());
+}
+
+TEST_F(LatencyStatsTest, first_measurement_sets_average) {
+    stats.record(milliseconds { 8 });
+    EXPECT_EQ(stats.getCount(), 1);
+    EXPECT_EQ(stats.getLast(), milliseconds { 8 });
+    EXPECT_EQ(stats.getMax(), milliseconds { 8 });
+    EXPECT_EQ(stats.getAverage(), milliseconds { 8 });
+}
+
+TEST_F(LatencyStatsTest, average_moves_towards_latest_measurement) {
+    stats.record(milliseconds { 8 });
+    stats.record(milliseconds { 16 });
+    EXPECT_EQ(stats.getLast(), milliseconds { 16 });
+    EXPECT_EQ(stats.getMax(), milliseconds { 16 });
+    EXPECT_EQ(stats.getAverage(), milliseconds { 9 });
+    stats.record(milliseconds { 1 });
+    EXPECT_EQ(stats.getLast(), milliseconds { 1 });
+    EXPECT_EQ(stats.getMax(), milliseconds { 16 });
+    EXPECT_EQ(stats.getAverage(), microseconds { 8000 });
+}
+
+TEST_F(LatencyStatsTest, single_stall_does_not_dominate_average) {
+    for (int i = 0; i < 100; i++) {
+        stats.record(microseconds { 500 });
+    }
+    stats.record(milliseconds { 500 });
+    EXPECT_EQ(stats.getMax(), milliseconds { 500 });
+    EXPECT_LT(stats.getAverage(), milliseconds { 70 });
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "LatenessHistogram.hpp"
+#include "RtcStored.hpp"
+
+using std::chrono::seconds;
+
+class LatenessHistogramTest : public ::testing::Test {
+public:
+    LatenessHistogram histogram {};
+};
+
+TEST_F(LatenessHistogramTest, empty_histogram) {
+    EXPECT_EQ(histogram.getCount(), 0);
+    EXPECT_EQ(histogram.getPercentile(50), milliseconds::zero());
+    EXPECT_EQ(histogram.getMax(), milliseconds::zero());
+}
+
+TEST_F(LatenessHistogramTest, single_sample_is_every_percentile) {
+    histogram.add(milliseconds { 150 });
+    EXPECT_EQ(histogram.getCount(), 1);
+    EXPECT_EQ(histogram.getPercentile(50), milliseconds { 150 });
+    EXPECT_EQ(histogram.getPercentile(95), milliseconds { 150 });
+    EXPECT_EQ(histogram.getMax(), milliseconds { 150 });
+}
+
+TEST_F(LatenessHistogramTest, percentiles_are_bucket_bounds) {
+    for (int i = 0; i < 90; i++) {
+        histogram.add(milliseconds { 15 });
+    }
+    for (int i = 0; i < 9; i++) {
+        histogram.add(milliseconds { 700 });
+    }
+    histogram.add(seconds { 3 });
+    EXPECT_EQ(histogram.getCount(), 100);
+    EXPECT_EQ(histogram.getPercentile(50), milliseconds { 20 });
+    EXPECT_EQ(histogram.getPercentile(90), milliseconds { 20 });
+    EXPECT_EQ(histogram.getPercentile(95), milliseconds { 1000 });
+    EXPECT_EQ(histogram.getPercentile(100), milliseconds { 3000 });
+    EXPECT_EQ(histogram.getMax(), seconds { 3 });
+}
+
+TEST_F(LatenessHistogramTest, very_late_samples_report_max) {
+    histogram.add(seconds { 90 });
+    histogram.add(seconds { 120 });
+    EXPECT_EQ(histogram.getPercentile(50), seconds { 120 });
+    EXPECT_EQ(histogram.getMax(), seconds { 120 });
+}
+
+TEST_F(LatenessHistogramTest, early_samples_count_as_on_time) {
+    histogram.add(milliseconds { -5 });
+    EXPECT_EQ(histogram.getPercentile(50), milliseconds::zero());
+    EXPECT_EQ(histogram.getMax(), milliseconds::zero());
+}
+
+TEST_F(LatenessHistogramTest, survives_rtc_storage) {
+    histogram.add(milliseconds { 15 });
+    histogram.add(milliseconds { 1500 });
+    RtcStored<LatenessHistogram> stored {};
+    stored.store(histogram);
+
+    LatenessHistogram restored {};
+    ASSERT_TRUE(stored.load(restored));
+    EXPECT_EQ(restored.getCount(), 2);
+    EXPECT_EQ(restored.getPercentile(50), milliseconds { 20 });
+    EXPECT_EQ(restored.getMax(), milliseconds { 1500 });
+}
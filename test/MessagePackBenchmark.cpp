@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <ArduinoJson.h>
+
+#include "Benchmark.hpp"
+
+using std::chrono::nanoseconds;
+
+const size_t ENCODE_COUNT = 10000;
+
+/**
+ * @brief Compares the size and speed of JSON and MessagePack over representative payloads.
+ */
+class MessagePackBenchmark : public ::testing::Test {
+public:
+    void compare(const char* name, const JsonDocument& doc) {
+        size_t jsonLength = 0;
+        auto jsonEncodeTime = Benchmark::measure<nanoseconds>([&]() {
+            jsonLength = serializeJson(doc, reinterpret_cast<char*>(buffer), sizeof(buffer));
+        }, ENCODE_COUNT);
+        ASSERT_GT(jsonLength, 0);
+        auto jsonDecodeTime = Benchmark::measure<nanoseconds>([&]() {
+            ASSERT_FALSE(deserializeJson(decoded, buffer, jsonLength));
+        }, ENCODE_COUNT);
+
+        size_t msgPackLength = 0;
+        auto msgPackEncodeTime = Benchmark::measure<nanoseconds>([&]() {
+            msgPackLength = serializeMsgPack(doc, buffer, sizeof(buffer));
+        }, ENCODE_COUNT);
+        ASSERT_GT(msgPackLength, 0);
+        auto msgPackDecodeTime = Benchmark::measure<nanoseconds>([&]() {
+            ASSERT_FALSE(deserializeMsgPack(decoded, buffer, msgPackLength));
+        }, ENCODE_COUNT);
+
+        std::cout << name << ": "
+                  << "json " << jsonLength << " bytes, encoded in " << jsonEncodeTime.count() << " ns, "
+                  << "decoded in " << jsonDecodeTime.count() << " ns; "
+                  << "msgpack " << msgPackLength << " bytes, encoded in " << msgPackEncodeTime.count() << " ns, "
+                  << "decoded in " << msgPackDecodeTime.count() << " ns" << std::endl;
+    }
+
+    uint8_t buffer[4096];
+    DynamicJsonDocument decoded { 8192 };
+};
+
+TEST_F(MessagePackBenchmark, DISABLED_single_zone_telemetry) {
+    DynamicJsonDocument doc(1024);
+    doc["volume"] = 0.125;
+    doc["flowRate"] = 7.5;
+    doc["valve"] = 1;
+    doc["temperature"] = 21.5;
+    doc["humidity"] = 54.25;
+    doc["soilTemperature"] = 17.75;
+    doc["soilMoisture"] = 37.5;
+    compare("Single zone telemetry", doc);
+}
+
+TEST_F(MessagePackBenchmark, DISABLED_eight_zone_telemetry) {
+    DynamicJsonDocument doc(2048);
+    doc["volume"] = 3.5;
+    doc["flowRate"] = 22.75;
+    JsonArray zones = doc.createNestedArray("zones");
+    for (int i = 0; i < 8; i++) {
+        JsonObject zone = zones.createNestedObject();
+        zone["valve"] = i % 2 == 0 ? 1 : -1;
+    }
+    doc["temperature"] = 21.5;
+    doc["humidity"] = 54.25;
+    compare("Eight zone telemetry", doc);
+}
+
+TEST_F(MessagePackBenchmark, DISABLED_valve_state_event) {
+    DynamicJsonDocument doc(256);
+    doc["zone"] = 3;
+    doc["state"] = 1;
+    compare("Valve state event", doc);
+}
+
+TEST_F(MessagePackBenchmark, DISABLED_journal_batch) {
+    DynamicJsonDocument doc(8192);
+    JsonArray records = doc.createNestedArray("records");
+    for (int i = 0; i < 10; i++) {
+        JsonObject record = records.createNestedObject();
+        record["timestamp"] = 1650000000 + i * 60;
+        JsonObject telemetry = record.createNestedObject("telemetry");
+        telemetry["volume"] = 0.125 * i;
+        telemetry["flowRate"] = 7.5;
+        telemetry["valve"] = 1;
+        telemetry["temperature"] = 21.5 + i * 0.25;
+        telemetry["humidity"] = 54.25;
+    }
+    compare("Journal batch of 10", doc);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "PulseSequencer.hpp"
+
+using Direction = PulseSequencer::Direction;
+
+class PulseSequencerTest : public ::testing::Test {
+public:
+    PulseSequencerTest() = default;
+
+    PulseSequencer sequencer;
+};
+
+TEST_F(PulseSequencerTest, starts_idle) {
+    EXPECT_FALSE(sequencer.isBusy());
+    EXPECT_EQ(sequencer.getActive(), Direction::NONE);
+    EXPECT_EQ(sequencer.getPending(), Direction::NONE);
+}
+
+TEST_F(PulseSequencerTest, starts_pulse_when_idle) {
+    EXPECT_EQ(sequencer.request(Direction::OPEN), Direction::OPEN);
+    EXPECT_TRUE(sequencer.isBusy());
+    EXPECT_EQ(sequencer.complete(), Direction::NONE);
+    EXPECT_FALSE(sequencer.isBusy());
+}
+
+TEST_F(PulseSequencerTest, ignores_none_request) {
+    EXPECT_EQ(sequencer.request(Direction::NONE), Direction::NONE);
+    EXPECT_FALSE(sequencer.isBusy());
+}
+
+TEST_F(PulseSequencerTest, queues_request_during_pulse) {
+    sequencer.request(Direction::OPEN);
+    EXPECT_EQ(sequencer.request(Direction::CLOSE), Direction::NONE);
+    EXPECT_EQ(sequencer.getPending(), Direction::CLOSE);
+    EXPECT_EQ(sequencer.complete(), Direction::CLOSE);
+    EXPECT_TRUE(sequencer.isBusy());
+    EXPECT_EQ(sequencer.complete(), Direction::NONE);
+}
+
+TEST_F(PulseSequencerTest, drops_request_matching_active_pulse) {
+    sequencer.request(Direction::OPEN);
+    EXPECT_EQ(sequencer.request(Direction::OPEN), Direction::NONE);
+    EXPECT_EQ(sequencer.getPending(), Direction::NONE);
+    EXPECT_EQ(sequencer.complete(), Direction::NONE);
+}
+
+TEST_F(PulseSequencerTest, coalesces_queued_requests_to_latest) {
+    sequencer.request(Direction::OPEN);
+    sequencer.request(Direction::CLOSE);
+    sequencer.request(Direction::OPEN);
+    EXPECT_EQ(sequencer.getPending(), Direction::NONE);
+    EXPECT_EQ(sequencer.complete(), Direction::NONE);
+
+    sequencer.request(Direction::CLOSE);
+    sequencer.request(Direction::OPEN);
+    sequencer.request(Direction::CLOSE);
+    sequencer.request(Direction::OPEN);
+    EXPECT_EQ(sequencer.getPending(), Direction::OPEN);
+    EXPECT_EQ(sequencer.complete(), Direction::OPEN);
+}
+
+TEST_F(PulseSequencerTest, cancel_drops_everything) {
+    sequencer.request(Direction::OPEN);
+    sequencer.request(Direction::CLOSE);
+    sequencer.cancel();
+    EXPECT_FALSE(sequencer.isBusy());
+    EXPECT_EQ(sequencer.getPending(), Direction::NONE);
+    EXPECT_EQ(sequencer.request(Direction::CLOSE), Direction::CLOSE);
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "RtcStored.hpp"
+
+struct StoredValue {
+    int64_t time;
+    int8_t source;
+};
+
+class RtcStoredTest : public ::testing::Test {
+public:
+    RtcStoredTest() {
+        // Mimic RTC memory after power-up
+        memset(&stored, 0, sizeof(stored));
+    }
+
+    RtcStored<StoredValue> stored;
+};
+
+TEST_F(RtcStoredTest, invalid_after_power_up) {
+    StoredValue value { 12, 1 };
+    EXPECT_FALSE(stored.isValid());
+    EXPECT_FALSE(stored.load(value));
+    EXPECT_EQ(value.time, 12);
+}
+
+TEST_F(RtcStoredTest, loads_stored_value) {
+    stored.store(StoredValue { 1234567890123, -1 });
+    StoredValue value {};
+    EXPECT_TRUE(stored.load(value));
+    EXPECT_EQ(value.time, 1234567890123);
+    EXPECT_EQ(value.source, -1);
+}
+
+TEST_F(RtcStoredTest, rejects_corrupted_value) {
+    stored.store(StoredValue { 1234567890123, 1 });
+    stored.value.time ^= 0x100;
+    StoredValue value {};
+    EXPECT_FALSE(stored.load(value));
+}
+
+TEST_F(RtcStoredTest, rejects_invalidated_value) {
+    stored.store(StoredValue { 1234567890123, 1 });
+    stored.invalidate();
+    StoredValue value {};
+    EXPECT_FALSE(stored.load(value));
+}
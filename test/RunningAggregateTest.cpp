@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "RunningAggregate.hpp"
+
+class RunningAggregateTest : public ::testing::Test {
+public:
+    RunningAggregate aggregate;
+};
+
+TEST_F(RunningAggregateTest, empty_aggregate_has_no_values) {
+    EXPECT_EQ(aggregate.getCount(), 0);
+    EXPECT_TRUE(std::isnan(aggregate.getMean()));
+    EXPECT_TRUE(std::isnan(aggregate.getMin()));
+    EXPECT_TRUE(std::isnan(aggregate.getMax()));
+    EXPECT_EQ(aggregate.getVariance(), 0);
+}
+
+TEST_F(RunningAggregateTest, aggregates_samples) {
+    for (double value : { 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 }) {
+        aggregate.add(value);
+    }
+    EXPECT_EQ(aggregate.getCount(), 8);
+    EXPECT_DOUBLE_EQ(aggregate.getMean(), 5.0);
+    EXPECT_DOUBLE_EQ(aggregate.getMin(), 2.0);
+    EXPECT_DOUBLE_EQ(aggregate.getMax(), 9.0);
+    EXPECT_DOUBLE_EQ(aggregate.getVariance(), 32.0 / 7);
+}
+
+TEST_F(RunningAggregateTest, handles_negative_samples) {
+    aggregate.add(-3.5);
+    aggregate.add(-1.5);
+    EXPECT_DOUBLE_EQ(aggregate.getMean(), -2.5);
+    EXPECT_DOUBLE_EQ(aggregate.getMin(), -3.5);
+    EXPECT_DOUBLE_EQ(aggregate.getMax(), -1.5);
+}
+
+TEST_F(RunningAggregateTest, ignores_failed_readings) {
+    aggregate.add(1.0);
+    aggregate.add(NAN);
+    aggregate.add(3.0);
+    EXPECT_EQ(aggregate.getCount(), 2);
+    EXPECT_DOUBLE_EQ(aggregate.getMean(), 2.0);
+}
+
+TEST_F(RunningAggregateTest, stays_stable_with_large_offset) {
+    for (int i = 0; i < 1000; i++) {
+        aggregate.add(1e9 + (i % 2 == 0 ? 0.5 : -0.5));
+    }
+    EXPECT_DOUBLE_EQ(aggregate.getMean(), 1e9);
+    EXPECT_NEAR(aggregate.getVariance(), 0.25 * 1000 / 999, 1e-6);
+}
+
+TEST_F(RunningAggregateTest, starts_over_after_reset) {
+    aggregate.add(10.0);
+    aggregate.reset();
+    aggregate.add(-1.0);
+    EXPECT_EQ(aggregate.getCount(), 1);
+    EXPECT_DOUBLE_EQ(aggregate.getMin(), -1.0);
+    EXPECT_DOUBLE_EQ(aggregate.getMax(), -1.0);
+}
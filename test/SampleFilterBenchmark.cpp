@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "SampleFilter.hpp"
+
+using std::chrono::nanoseconds;
+
+const size_t FILTER_BURST_SIZE = 64;
+const size_t FILTER_ITERATIONS = 10000;
+
+class SampleFilterBenchmark : public ::testing::Test {
+public:
+    SampleFilterBenchmark() {
+        std::mt19937 random(42);
+        std::normal_distribution<double> noise(4000, 20);
+        std::uniform_int_distribution<int> spike(0, 19);
+        for (size_t i = 0; i < FILTER_BURST_SIZE; i++) {
+            burst.push_back(spike(random) == 0 ? 8191 : static_cast<uint16_t>(noise(random)));
+        }
+    }
+
+    std::vector<uint16_t> burst;
+};
+
+TEST_F(SampleFilterBenchmark, DISABLED_reduces_burst) {
+    std::vector<uint16_t> samples;
+    double mean = 0;
+    auto meanTime = Benchmark::measure<nanoseconds>([&]() {
+        samples = burst;
+        double sum = 0;
+        for (auto sample : samples) {
+            sum += sample;
+        }
+        mean = sum / samples.size();
+    }, FILTER_ITERATIONS);
+    double filtered = 0;
+    auto filterTime = Benchmark::measure<nanoseconds>([&]() {
+        samples = burst;
+        filtered = SampleFilter::medianTrimmedMean(samples.data(), samples.size(), 5, 0.2);
+    }, FILTER_ITERATIONS);
+    EXPECT_NEAR(filtered, 4000, 20);
+
+    std::cout << "Reduced " << FILTER_BURST_SIZE << " samples: "
+              << "mean " << mean << " in " << meanTime.count() << " ns, "
+              << "median-of-5 trimmed mean " << filtered << " in " << filterTime.count() << " ns" << std::endl;
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "SampleFilter.hpp"
+
+class SampleFilterTest : public ::testing::Test {
+};
+
+TEST_F(SampleFilterTest, median_of_odd_count) {
+    std::vector<int> values { 5, 1, 9, 3, 7 };
+    EXPECT_DOUBLE_EQ(SampleFilter::median(values.data(), values.size()), 5);
+}
+
+TEST_F(SampleFilterTest, median_of_even_count) {
+    std::vector<int> values { 8, 2, 6, 4 };
+    EXPECT_DOUBLE_EQ(SampleFilter::median(values.data(), values.size()), 5);
+}
+
+TEST_F(SampleFilterTest, median_of_nothing) {
+    EXPECT_TRUE(std::isnan(SampleFilter::median<int>(nullptr, 0)));
+}
+
+TEST_F(SampleFilterTest, trimmed_mean_drops_extremes) {
+    std::vector<int> values { 100, 10, 11, 12, 13, 14, 15, 16, 17, -100 };
+    EXPECT_DOUBLE_EQ(SampleFilter::trimmedMean(values.data(), values.size(), 0.1), 13.5);
+}
+
+TEST_F(SampleFilterTest, trimmed_mean_keeps_at_least_one_value) {
+    std::vector<int> values { 1, 2, 3 };
+    EXPECT_DOUBLE_EQ(SampleFilter::trimmedMean(values.data(), values.size(), 0.5), 2);
+    std::vector<int> single { 42 };
+    EXPECT_DOUBLE_EQ(SampleFilter::trimmedMean(single.data(), single.size(), 0.5), 42);
+}
+
+TEST_F(SampleFilterTest, rejects_spikes) {
+    std::vector<uint16_t> samples;
+    for (int i = 0; i < 64; i++) {
+        // Noise of +/- 2 around 4000, with a full-scale spike in every other window
+        samples.push_back(i % 10 == 3 ? 8191 : 4000 + (i % 5) - 2);
+    }
+    EXPECT_NEAR(SampleFilter::medianTrimmedMean(samples.data(), samples.size(), 5, 0.2), 4000, 1);
+}
+
+TEST_F(SampleFilterTest, ignores_partial_window) {
+    std::vector<int> samples { 1, 2, 3, 4, 5, 6, 1000 };
+    EXPECT_DOUBLE_EQ(SampleFilter::medianTrimmedMean(samples.data(), samples.size(), 3, 0), 3.5);
+}
+
+TEST_F(SampleFilterTest, falls_back_to_median_without_full_window) {
+    std::vector<int> samples { 3, 1000, 2 };
+    EXPECT_DOUBLE_EQ(SampleFilter::medianTrimmedMean(samples.data(), samples.size(), 5, 0.2), 3);
+}
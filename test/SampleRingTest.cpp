@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "SampleRing.hpp"
+
+class SampleRingTest : public ::testing::Test {
+public:
+    SampleRingTest() {
+        // Mimic RTC memory after power-up
+        memset(&ring, 0, sizeof(ring));
+    }
+
+    SampleRing<int, 3> ring;
+};
+
+TEST_F(SampleRingTest, invalid_until_reset) {
+    EXPECT_FALSE(ring.isValid());
+    ring.reset();
+    EXPECT_TRUE(ring.isValid());
+    EXPECT_EQ(ring.size(), 0);
+}
+
+TEST_F(SampleRingTest, keeps_samples_in_order) {
+    ring.reset();
+    ring.push(1);
+    ring.push(2);
+    ASSERT_EQ(ring.size(), 2);
+    EXPECT_FALSE(ring.isFull());
+    EXPECT_EQ(ring.get(0), 1);
+    EXPECT_EQ(ring.get(1), 2);
+}
+
+TEST_F(SampleRingTest, overwrites_oldest_when_full) {
+    ring.reset();
+    for (int i = 1; i <= 5; i++) {
+        ring.push(i);
+    }
+    ASSERT_EQ(ring.size(), 3);
+    EXPECT_TRUE(ring.isFull());
+    EXPECT_EQ(ring.get(0), 3);
+    EXPECT_EQ(ring.get(1), 4);
+    EXPECT_EQ(ring.get(2), 5);
+}
+
+TEST_F(SampleRingTest, packs_hundredths) {
+    EXPECT_EQ(PackedSample::packHundredths(21.456), 2146);
+    EXPECT_EQ(PackedSample::packHundredths(-5.5), -550);
+    EXPECT_DOUBLE_EQ(PackedSample::unpackHundredths(2146), 21.46);
+    EXPECT_EQ(PackedSample::packHundredths(NAN), PACKED_SAMPLE_MISSING);
+    EXPECT_TRUE(std::isnan(PackedSample::unpackHundredths(PACKED_SAMPLE_MISSING)));
+}
+
+TEST_F(SampleRingTest, saturates_packed_values) {
+    EXPECT_EQ(PackedSample::packHundredths(1000), INT16_MAX);
+    EXPECT_EQ(PackedSample::packHundredths(-1000), PACKED_SAMPLE_MISSING + 1);
+}
+
+TEST_F(SampleRingTest, packs_open_zones) {
+    PackedSample sample {};
+    sample.setZoneOpen(0, true);
+    sample.setZoneOpen(7, true);
+    sample.setZoneOpen(8, true);
+    EXPECT_EQ(sample.openZones, 0x81);
+    EXPECT_TRUE(sample.isZoneOpen(7));
+    EXPECT_FALSE(sample.isZoneOpen(1));
+    EXPECT_FALSE(sample.isZoneOpen(8));
+    sample.setZoneOpen(0, false);
+    EXPECT_EQ(sample.openZones, 0x80);
+}
+
+TEST_F(SampleRingTest, sample_is_compact) {
+    EXPECT_EQ(sizeof(PackedSample), 20);
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "SensorHealth.hpp"
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::chrono::time_point;
+
+using State = SensorHealth<steady_clock>::State;
+
+class SensorHealthTest : public ::testing::Test {
+public:
+    SensorHealthTest() = default;
+
+    const time_point<steady_clock> base { steady_clock::now() };
+    SensorHealth<steady_clock> health { 3, seconds { 10 }, seconds { 60 } };
+};
+
+TEST_F(SensorHealthTest, healthy_initially) {
+    EXPECT_EQ(health.getState(), State::HEALTHY);
+    EXPECT_TRUE(health.isAttemptDue(base));
+    EXPECT_FALSE(health.needsReinit());
+}
+
+TEST_F(SensorHealthTest, keeps_trying_while_failing) {
+    health.recordFailure(base);
+    health.recordFailure(base);
+    EXPECT_EQ(health.getState(), State::FAILING);
+    EXPECT_TRUE(health.isAttemptDue(base));
+    EXPECT_FALSE(health.needsReinit());
+    EXPECT_EQ(health.getConsecutiveFailures(), 2);
+}
+
+TEST_F(SensorHealthTest, goes_offline_after_consecutive_failures) {
+    for (int i = 0; i < 3; i++) {
+        health.recordFailure(base);
+    }
+    EXPECT_EQ(health.getState(), State::OFFLINE);
+    EXPECT_TRUE(health.needsReinit());
+    EXPECT_FALSE(health.isAttemptDue(base + seconds { 9 }));
+    EXPECT_TRUE(health.isAttemptDue(base + seconds { 10 }));
+}
+
+TEST_F(SensorHealthTest, backs_off_exponentially_up_to_maximum) {
+    health.markOffline(base);
+    EXPECT_EQ(health.getBackoff(), seconds { 10 });
+    health.recordFailure(base + seconds { 10 });
+    EXPECT_EQ(health.getBackoff(), seconds { 20 });
+    EXPECT_EQ(health.getNextAttempt(), base + seconds { 30 });
+    health.recordFailure(base + seconds { 30 });
+    EXPECT_EQ(health.getBackoff(), seconds { 40 });
+    health.recordFailure(base + seconds { 70 });
+    EXPECT_EQ(health.getBackoff(), seconds { 60 });
+    health.recordFailure(base + seconds { 130 });
+    EXPECT_EQ(health.getBackoff(), seconds { 60 });
+}
+
+TEST_F(SensorHealthTest, recovers_after_success) {
+    health.markOffline(base);
+    health.recordFailure(base + seconds { 10 });
+    health.recordReinit();
+    health.recordSuccess();
+    EXPECT_EQ(health.getState(), State::HEALTHY);
+    EXPECT_EQ(health.getConsecutiveFailures(), 0);
+    EXPECT_EQ(health.getBackoff(), seconds { 10 });
+    EXPECT_EQ(health.getFailureCount(), 1);
+    EXPECT_EQ(health.getReinitCount(), 1);
+    EXPECT_EQ(health.getSuccessCount(), 1);
+    EXPECT_TRUE(health.isAttemptDue(base + seconds { 11 }));
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "Sht3x.hpp"
+
+class Sht3xTest : public ::testing::Test {
+};
+
+TEST_F(Sht3xTest, calculates_crc_from_datasheet) {
+    const uint8_t data[] = { 0xBE, 0xEF };
+    EXPECT_EQ(Sht3x::crc8(data, 2), 0x92);
+}
+
+TEST_F(Sht3xTest, parses_measurement) {
+    // 0x6666 is 25 °C, 0x8000 is 50 %RH
+    uint8_t data[] = { 0x66, 0x66, 0, 0x80, 0x00, 0 };
+    data[2] = Sht3x::crc8(data, 2);
+    data[5] = Sht3x::crc8(data + 3, 2);
+    double temperature;
+    double humidity;
+    ASSERT_TRUE(Sht3x::parseMeasurement(data, temperature, humidity));
+    EXPECT_NEAR(temperature, 25.0, 0.01);
+    EXPECT_NEAR(humidity, 50.0, 0.01);
+}
+
+TEST_F(Sht3xTest, parses_limits) {
+    uint8_t data[] = { 0x00, 0x00, 0, 0xFF, 0xFF, 0 };
+    data[2] = Sht3x::crc8(data, 2);
+    data[5] = Sht3x::crc8(data + 3, 2);
+    double temperature;
+    double humidity;
+    ASSERT_TRUE(Sht3x::parseMeasurement(data, temperature, humidity));
+    EXPECT_DOUBLE_EQ(temperature, -45.0);
+    EXPECT_DOUBLE_EQ(humidity, 100.0);
+}
+
+TEST_F(Sht3xTest, rejects_corrupted_measurement) {
+    uint8_t data[] = { 0x66, 0x66, 0, 0x80, 0x00, 0 };
+    data[2] = Sht3x::crc8(data, 2);
+    data[5] = Sht3x::crc8(data + 3, 2);
+    data[4] ^= 0x01;
+    double temperature;
+    double humidity;
+    EXPECT_FALSE(Sht3x::parseMeasurement(data, temperature, humidity));
+}
+
+TEST_F(Sht3xTest, selects_periodic_command_by_rate) {
+    uint16_t command;
+    ASSERT_TRUE(Sht3x::getPeriodicCommand(0.5, command));
+    EXPECT_EQ(command, 0x2032);
+    ASSERT_TRUE(Sht3x::getPeriodicCommand(10, command));
+    EXPECT_EQ(command, 0x2737);
+    EXPECT_FALSE(Sht3x::getPeriodicCommand(3, command));
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+
+#include "TaskProfile.hpp"
+
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+class TaskProfileTest : public ::testing::Test {
+public:
+    TaskProfile profile { "test" };
+};
+
+TEST_F(TaskProfileTest, empty_profile) {
+    EXPECT_EQ(profile.getWakes(), 0);
+    EXPECT_EQ(profile.getMaxLoop(), microseconds::zero());
+    for (size_t bucket = 0; bucket < TASK_PROFILE_BUCKETS; bucket++) {
+        EXPECT_EQ(profile.getHistogram(bucket), 0);
+    }
+}
+
+TEST_F(TaskProfileTest, buckets_by_decade) {
+    EXPECT_EQ(TaskProfile::getBucket(microseconds { 0 }), 0);
+    EXPECT_EQ(TaskProfile::getBucket(microseconds { 9 }), 0);
+    EXPECT_EQ(TaskProfile::getBucket(microseconds { 10 }), 1);
+    EXPECT_EQ(TaskProfile::getBucket(microseconds { 999 }), 2);
+    EXPECT_EQ(TaskProfile::getBucket(milliseconds { 1 }), 3);
+    EXPECT_EQ(TaskProfile::getBucket(milliseconds { 99 }), 4);
+    EXPECT_EQ(TaskProfile::getBucket(milliseconds { 100 }), 5);
+    EXPECT_EQ(TaskProfile::getBucket(seconds { 10 }), 5);
+}
+
+TEST_F(TaskProfileTest, records_loops) {
+    profile.recordLoop(microseconds { 50 });
+    profile.recordLoop(milliseconds { 2 });
+    profile.recordLoop(microseconds { 70 });
+    EXPECT_EQ(profile.getWakes(), 3);
+    EXPECT_EQ(profile.getMaxLoop(), milliseconds { 2 });
+    EXPECT_EQ(profile.getTotalLoop(), microseconds { 2120 });
+    EXPECT_EQ(profile.getHistogram(1), 2);
+    EXPECT_EQ(profile.getHistogram(3), 1);
+}
+
+TEST_F(TaskProfileTest, records_last_sleep) {
+    profile.recordSleep(seconds { 1 });
+    profile.recordSleep(milliseconds { 500 });
+    EXPECT_EQ(profile.getLastSleep(), milliseconds { 500 });
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.hpp"
+#include "TelemetryJournal.hpp"
+
+// Same geometry as the 192 KB spiffs partition
+const size_t JOURNAL_SECTOR_SIZE = 4096;
+const size_t JOURNAL_SECTOR_COUNT = 48;
+const size_t JOURNAL_RECORD_COUNT = 10000;
+
+class TelemetryJournalBenchmark : public ::testing::Test {
+public:
+    const std::string record { R"({"volume":0.125,"flowRate":7.5,"valve":1,"temperature":21.5,"humidity":54.25,"soilMoisture":37.5})" };
+    MemoryJournalStorage storage { JOURNAL_SECTOR_SIZE, JOURNAL_SECTOR_COUNT };
+};
+
+TEST_F(TelemetryJournalBenchmark, DISABLED_appends_and_replays_in_batches) {
+    TelemetryJournal journal(storage);
+    journal.begin();
+
+    auto appendTime = Benchmark::measure([&]() {
+        for (size_t i = 0; i < JOURNAL_RECORD_COUNT; i++) {
+            journal.append(i, record.data(), record.size());
+        }
+    });
+    size_t pending = journal.getPendingCount();
+
+    TelemetryJournal restarted(storage);
+    auto scanTime = Benchmark::measure([&]() {
+        restarted.begin();
+    });
+    EXPECT_EQ(restarted.getPendingCount(), pending);
+
+    size_t replayed = 0;
+    size_t batches = 0;
+    std::vector<JournalRecord> records;
+    auto replayTime = Benchmark::measure([&]() {
+        while (restarted.readBatch(10, records) > 0) {
+            replayed += records.size();
+            batches++;
+            restarted.consume(records);
+        }
+    });
+    EXPECT_EQ(replayed, pending);
+
+    size_t maxErases = 0;
+    size_t minErases = SIZE_MAX;
+    for (size_t sector = 0; sector < JOURNAL_SECTOR_COUNT; sector++) {
+        maxErases = std::max(maxErases, storage.getEraseCount(sector));
+        minErases = std::min(minErases, storage.getEraseCount(sector));
+    }
+
+    std::cout << "Appended " << JOURNAL_RECORD_COUNT << " records in " << appendTime.count() << " us, "
+              << pending << " kept, " << journal.getDroppedCount() << " dropped; "
+              << "scanned in " << scanTime.count() << " us; "
+              << "replayed in " << batches << " batches in " << replayTime.count() << " us; "
+              << "erases per sector " << minErases << "-" << maxErases << std::endl;
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "TelemetryJournal.hpp"
+
+class TelemetryJournalTest : public ::testing::Test {
+public:
+    TelemetryJournalTest() {
+        journal.begin();
+    }
+
+    bool append(uint32_t timestamp, const std::string& data) {
+        return journal.append(timestamp, data.data(), data.size());
+    }
+
+    static std::string asString(const JournalRecord& record) {
+        return std::string(record.data.begin(), record.data.end());
+    }
+
+    MemoryJournalStorage storage { 256, 4 };
+    TelemetryJournal journal { storage };
+    std::vector<JournalRecord> records;
+};
+
+TEST_F(TelemetryJournalTest, empty_after_format) {
+    EXPECT_EQ(journal.getPendingCount(), 0);
+    EXPECT_EQ(journal.readBatch(10, records), 0);
+}
+
+TEST_F(TelemetryJournalTest, reads_back_in_order) {
+    EXPECT_TRUE(append(100, "first"));
+    EXPECT_TRUE(append(200, "second"));
+    EXPECT_EQ(journal.getPendingCount(), 2);
+
+    ASSERT_EQ(journal.readBatch(10, records), 2);
+    EXPECT_EQ(records[0].timestamp, 100);
+    EXPECT_EQ(asString(records[0]), "first");
+    EXPECT_EQ(records[1].timestamp, 200);
+    EXPECT_EQ(asString(records[1]), "second");
+}
+
+TEST_F(TelemetryJournalTest, reads_in_batches) {
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(append(i, "record " + std::to_string(i)));
+    }
+    ASSERT_EQ(journal.readBatch(2, records), 2);
+    EXPECT_EQ(asString(records[0]), "record 0");
+    // Reading without consuming returns the same records
+    ASSERT_EQ(journal.readBatch(2, records), 2);
+    EXPECT_EQ(asString(records[0]), "record 0");
+    journal.consume(records);
+    EXPECT_EQ(journal.getPendingCount(), 3);
+
+    ASSERT_EQ(journal.readBatch(2, records), 2);
+    EXPECT_EQ(asString(records[0]), "record 2");
+    journal.consume(records);
+    ASSERT_EQ(journal.readBatch(2, records), 1);
+    EXPECT_EQ(asString(records[0]), "record 4");
+    journal.consume(records);
+    EXPECT_EQ(journal.getPendingCount(), 0);
+    EXPECT_EQ(journal.readBatch(2, records), 0);
+}
+
+TEST_F(TelemetryJournalTest, rejects_oversized_record) {
+    EXPECT_FALSE(append(1, std::string(journal.getMaxRecordSize() + 1, 'x')));
+    EXPECT_TRUE(append(1, std::string(journal.getMaxRecordSize(), 'x')));
+}
+
+TEST_F(TelemetryJournalTest, spans_sectors) {
+    std::string data(100, 'x');
+    for (int i = 0; i < 6; i++) {
+        EXPECT_TRUE(append(i, data));
+    }
+    ASSERT_EQ(journal.readBatch(10, records), 6);
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(records[i].timestamp, i);
+    }
+}
+
+TEST_F(TelemetryJournalTest, drops_oldest_sector_when_full) {
+    std::string data(100, 'x');
+    // Two records fit in a sector
+    for (int i = 0; i < 9; i++) {
+        EXPECT_TRUE(append(i, data));
+    }
+    EXPECT_EQ(journal.getDroppedCount(), 2);
+    EXPECT_EQ(journal.getPendingCount(), 7);
+    ASSERT_EQ(journal.readBatch(10, records), 7);
+    EXPECT_EQ(records[0].timestamp, 2);
+    EXPECT_EQ(records[6].timestamp, 8);
+}
+
+TEST_F(TelemetryJournalTest, wears_sectors_evenly) {
+    std::string data(100, 'x');
+    for (int i = 0; i < 80; i++) {
+        EXPECT_TRUE(append(i, data));
+        ASSERT_EQ(journal.readBatch(1, records), 1);
+        journal.consume(records);
+    }
+    for (size_t sector = 0; sector < 4; sector++) {
+        EXPECT_EQ(storage.getEraseCount(sector), 10);
+    }
+    EXPECT_EQ(journal.getDroppedCount(), 0);
+}
+
+TEST_F(TelemetryJournalTest, recovers_after_restart) {
+    std::string data(100, 'x');
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(append(i, data));
+    }
+    ASSERT_EQ(journal.readBatch(2, records), 2);
+    journal.consume(records);
+
+    TelemetryJournal restarted(storage);
+    restarted.begin();
+    EXPECT_EQ(restarted.getPendingCount(), 3);
+    EXPECT_TRUE(restarted.append(5, data.data(), data.size()));
+    ASSERT_EQ(restarted.readBatch(10, records), 4);
+    EXPECT_EQ(records[0].timestamp, 2);
+    EXPECT_EQ(records[3].timestamp, 5);
+}
+
+TEST_F(TelemetryJournalTest, recovers_after_wrapping_around) {
+    std::string data(100, 'x');
+    for (int i = 0; i < 11; i++) {
+        EXPECT_TRUE(append(i, data));
+    }
+
+    TelemetryJournal restarted(storage);
+    restarted.begin();
+    EXPECT_EQ(restarted.getPendingCount(), 7);
+    ASSERT_EQ(restarted.readBatch(10, records), 7);
+    EXPECT_EQ(records[0].timestamp, 4);
+    EXPECT_EQ(records[6].timestamp, 10);
+}
+
+TEST_F(TelemetryJournalTest, skips_corrupted_record) {
+    EXPECT_TRUE(append(1, "first"));
+    EXPECT_TRUE(append(2, "second"));
+    EXPECT_TRUE(append(3, "third"));
+    // Flip a payload bit of the second record
+    storage.getData()[8 + 8 + 8 + 8 + 1] ^= 0x01;
+
+    TelemetryJournal restarted(storage);
+    restarted.begin();
+    EXPECT_EQ(restarted.getPendingCount(), 2);
+    ASSERT_EQ(restarted.readBatch(10, records), 2);
+    EXPECT_EQ(asString(records[0]), "first");
+    EXPECT_EQ(asString(records[1]), "third");
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "SampleRing.hpp"
+#include "TraceEvent.hpp"
+
+class TraceEventTest : public ::testing::Test {
+public:
+    char buffer[64];
+};
+
+TEST_F(TraceEventTest, formats_span_boundaries) {
+    TraceEvent begin { 1234567, "valve/evaluate", 0x3ffb8c2c, TracePhase::BEGIN };
+    TraceEvent end { 1234890, "valve/evaluate", 0x3ffb8c2c, TracePhase::END };
+    TraceEvent::format(begin, buffer, sizeof(buffer));
+    EXPECT_STREQ(buffer, "trace B 1234567 3ffb8c2c valve/evaluate");
+    TraceEvent::format(end, buffer, sizeof(buffer));
+    EXPECT_STREQ(buffer, "trace E 1234890 3ffb8c2c valve/evaluate");
+}
+
+TEST_F(TraceEventTest, formats_instant_events) {
+    TraceEvent event { 5000000000, "valve/retry", 0x1f, TracePhase::INSTANT };
+    TraceEvent::format(event, buffer, sizeof(buffer));
+    EXPECT_STREQ(buffer, "trace i 5000000000 0000001f valve/retry");
+}
+
+TEST_F(TraceEventTest, truncates_to_buffer) {
+    // Only the name can be longer than the buffer, the rest of the line always fits
+    std::string name(100, 'x');
+    TraceEvent event { 1, name.c_str(), 0, TracePhase::BEGIN };
+    int length = TraceEvent::format(event, buffer, sizeof(buffer));
+    EXPECT_EQ(length, 119);
+    EXPECT_EQ(std::string(buffer), "trace B 1 00000000 " + std::string(sizeof(buffer) - 20, 'x'));
+}
+
+TEST_F(TraceEventTest, ring_keeps_latest_events) {
+    SampleRing<TraceEvent, 4> ring;
+    ring.reset();
+    for (int64_t timestamp = 0; timestamp < 6; timestamp++) {
+        ring.push({ timestamp, "event", 0, TracePhase::INSTANT });
+    }
+    EXPECT_EQ(ring.size(), 4);
+    EXPECT_EQ(ring.get(0).timestamp, 2);
+    EXPECT_EQ(ring.get(3).timestamp, 5);
+}
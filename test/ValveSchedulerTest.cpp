@@ -95,3 +95,63 @@ TEST_F(ValveSchedulerTest, matches_multiple_schedules) {
     EXPECT_TRUE(scheduler.isScheduled(schedules, base + minutes { 2 } + seconds { 74 }));
     EXPECT_FALSE(scheduler.isScheduled(schedules, base + minutes { 2 } + seconds { 75 }));
 }
+
+TEST_F(ValveSchedulerTest, no_next_change_when_empty) {
+    EXPECT_EQ(scheduler.getNextChange({}, base), time_point<system_clock>::max());
+}
+
+TEST_F(ValveSchedulerTest, next_change_is_start_or_end_of_period) {
+    std::list<ValveSchedule> schedules {
+        ValveSchedule(base, minutes { 1 }, seconds { 15 }),
+    };
+    EXPECT_EQ(scheduler.getNextChange(schedules, base - seconds { 10 }), base);
+    EXPECT_EQ(scheduler.getNextChange(schedules, base), base + seconds { 15 });
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 14 }), base + seconds { 15 });
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 15 }), base + seconds { 60 });
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 59 }), base + seconds { 60 });
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 60 }), base + seconds { 75 });
+}
+
+TEST_F(ValveSchedulerTest, next_change_is_earliest_of_multiple_schedules) {
+    std::list<ValveSchedule> schedules {
+        ValveSchedule(base, minutes { 1 }, seconds { 15 }),
+        ValveSchedule(base + seconds { 20 }, minutes { 5 }, seconds { 60 }),
+    };
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 15 }), base + seconds { 20 });
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 20 }), base + seconds { 60 });
+    EXPECT_EQ(scheduler.getNextChange(schedules, base + seconds { 75 }), base + seconds { 80 });
+}
+
+TEST_F(ValveSchedulerTest, no_last_change_when_empty) {
+    EXPECT_EQ(scheduler.getLastChange({}, base), time_point<system_clock>::min());
+}
+
+TEST_F(ValveSchedulerTest, no_last_change_before_schedule_starts) {
+    std::list<ValveSchedule> schedules {
+        ValveSchedule(base, minutes { 1 }, seconds { 15 }),
+    };
+    EXPECT_EQ(scheduler.getLastChange(schedules, base - seconds { 10 }), time_point<system_clock>::min());
+}
+
+TEST_F(ValveSchedulerTest, last_change_is_start_or_end_of_period) {
+    std::list<ValveSchedule> schedules {
+        ValveSchedule(base, minutes { 1 }, seconds { 15 }),
+    };
+    EXPECT_EQ(scheduler.getLastChange(schedules, base), base);
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 14 }), base);
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 15 }), base + seconds { 15 });
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 59 }), base + seconds { 15 });
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 60 }), base + seconds { 60 });
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 80 }), base + seconds { 75 });
+}
+
+TEST_F(ValveSchedulerTest, last_change_is_latest_of_multiple_schedules) {
+    std::list<ValveSchedule> schedules {
+        ValveSchedule(base, minutes { 1 }, seconds { 15 }),
+        ValveSchedule(base + seconds { 20 }, minutes { 5 }, seconds { 60 }),
+    };
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 19 }), base + seconds { 15 });
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 30 }), base + seconds { 20 });
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 70 }), base + seconds { 60 });
+    EXPECT_EQ(scheduler.getLastChange(schedules, base + seconds { 85 }), base + seconds { 80 });
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+
+#include "Benchmark.hpp"
+#include "ZoneProgramPlanner.hpp"
+
+using std::chrono::hours;
+using std::chrono::minutes;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+const size_t PROGRAM_COUNT = 500;
+const size_t ZONE_COUNT = 8;
+
+class ZoneProgramPlannerBenchmark : public ::testing::Test {
+public:
+    ZoneProgramPlannerBenchmark() {
+        for (size_t i = 0; i < PROGRAM_COUNT; i++) {
+            ZoneProgram program { base + minutes { (long) (i % 48) * 30 }, {} };
+            for (size_t step = 0; step < 3; step++) {
+                program.steps.push_back(ZoneProgramStep { (i + step) % ZONE_COUNT, minutes { (long) 5 + (i + step) % 10 }, 0 });
+            }
+            programs.push_back(program);
+        }
+        for (int day = 0; day < 7; day++) {
+            windows.push_back({ base + hours { day * 24 + 4 }, base + hours { day * 24 + 10 } });
+            windows.push_back({ base + hours { day * 24 + 16 }, base + hours { day * 24 + 23 } });
+        }
+    }
+
+    const time_point<system_clock> base { system_clock::from_time_t(1577836800) };
+    std::vector<ZoneProgram> programs;
+    std::vector<ZoneProgramPlanner::Window> windows;
+};
+
+TEST_F(ZoneProgramPlannerBenchmark, DISABLED_plans_hundreds_of_programs) {
+    ZoneProgramPlanner planner(2, 0);
+    planner.setWindows(windows);
+
+    auto fullPlan = Benchmark::measure([&]() {
+        planner.setPrograms(programs);
+    });
+    EXPECT_EQ(planner.getLastReplanned(), PROGRAM_COUNT);
+
+    programs[PROGRAM_COUNT - 10].steps[1].duration += minutes { 1 };
+    auto tailPlan = Benchmark::measure([&]() {
+        planner.setPrograms(programs);
+    });
+    EXPECT_EQ(planner.getLastReplanned(), 10);
+
+    size_t plannedCount = 0;
+    for (size_t i = 0; i < PROGRAM_COUNT; i++) {
+        plannedCount += planner.isPlanned(i) ? 1 : 0;
+    }
+
+    std::cout << "Planned " << plannedCount << " of " << PROGRAM_COUNT << " programs ("
+              << planner.getRuns().size() << " runs) in " << fullPlan.count() << " us, "
+              << "replanned last 10 in " << tailPlan.count() << " us" << std::endl;
+}
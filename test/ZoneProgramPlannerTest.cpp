@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include "ZoneProgramPlanner.hpp"
+
+using std::chrono::hours;
+using std::chrono::minutes;
+using std::chrono::seconds;
+using std::chrono::system_clock;
+using std::chrono::time_point;
+
+class ZoneProgramPlannerTest : public ::testing::Test {
+public:
+    ZoneProgramPlannerTest() = default;
+
+    ZoneProgramStep step(size_t zone, seconds duration) {
+        return ZoneProgramStep { zone, duration, 0 };
+    }
+
+    ZoneProgramStep volumeStep(size_t zone, double volume) {
+        return ZoneProgramStep { zone, seconds::zero(), volume };
+    }
+
+    const time_point<system_clock> base { system_clock::from_time_t(1577836800) };
+};
+
+TEST_F(ZoneProgramPlannerTest, runs_steps_in_sequence) {
+    ZoneProgramPlanner planner;
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }), step(1, minutes { 5 }) } },
+    });
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 2);
+    EXPECT_EQ(runs[0].zone, 0);
+    EXPECT_EQ(runs[0].start, base);
+    EXPECT_EQ(runs[0].end, base + minutes { 10 });
+    EXPECT_EQ(runs[1].zone, 1);
+    EXPECT_EQ(runs[1].start, base + minutes { 10 });
+    EXPECT_EQ(runs[1].end, base + minutes { 15 });
+    EXPECT_TRUE(planner.isPlanned(0));
+}
+
+TEST_F(ZoneProgramPlannerTest, reports_active_zones) {
+    ZoneProgramPlanner planner;
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }), step(1, minutes { 5 }) } },
+    });
+    EXPECT_FALSE(planner.isZoneActive(0, base - seconds { 1 }));
+    EXPECT_TRUE(planner.isZoneActive(0, base));
+    EXPECT_FALSE(planner.isZoneActive(1, base));
+    EXPECT_FALSE(planner.isZoneActive(0, base + minutes { 10 }));
+    EXPECT_TRUE(planner.isZoneActive(1, base + minutes { 10 }));
+    EXPECT_FALSE(planner.isZoneActive(1, base + minutes { 15 }));
+    EXPECT_EQ(planner.getNextChange(base), base + minutes { 10 });
+    EXPECT_EQ(planner.getNextChange(base + minutes { 10 }), base + minutes { 15 });
+    EXPECT_EQ(planner.getNextChange(base + minutes { 15 }), time_point<system_clock>::max());
+}
+
+TEST_F(ZoneProgramPlannerTest, limits_concurrent_zones) {
+    ZoneProgramPlanner planner(2, 0);
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }) } },
+        ZoneProgram { base, { step(1, minutes { 20 }) } },
+        ZoneProgram { base, { step(2, minutes { 10 }) } },
+        ZoneProgram { base, { step(3, minutes { 10 }) } },
+    });
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 4);
+    EXPECT_EQ(runs[0].start, base);
+    EXPECT_EQ(runs[1].start, base);
+    EXPECT_EQ(runs[2].start, base + minutes { 10 });
+    EXPECT_EQ(runs[3].start, base + minutes { 20 });
+}
+
+TEST_F(ZoneProgramPlannerTest, limits_flow) {
+    ZoneProgramPlanner planner(0, 30);
+    planner.setZoneFlowRates({ 20, 10, 15 });
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }) } },
+        ZoneProgram { base, { step(1, minutes { 5 }) } },
+        ZoneProgram { base, { step(2, minutes { 10 }) } },
+    });
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 3);
+    EXPECT_EQ(runs[0].start, base);
+    EXPECT_EQ(runs[1].start, base);
+    EXPECT_EQ(runs[2].start, base + minutes { 10 });
+}
+
+TEST_F(ZoneProgramPlannerTest, converts_volume_to_duration) {
+    ZoneProgramPlanner planner;
+    planner.setZoneFlowRates({ 10 });
+    planner.setPrograms({
+        ZoneProgram { base, { volumeStep(0, 25) } },
+    });
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 1);
+    EXPECT_EQ(runs[0].end, base + seconds { 150 });
+}
+
+TEST_F(ZoneProgramPlannerTest, rejects_volume_step_without_flow_rate) {
+    ZoneProgramPlanner planner;
+    planner.setZoneFlowRates({ 10 });
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }), volumeStep(1, 25) } },
+        ZoneProgram { base, { volumeStep(0, 25) } },
+    });
+    EXPECT_FALSE(planner.isPlanned(0));
+    EXPECT_TRUE(planner.isPlanned(1));
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 1);
+    EXPECT_EQ(runs[0].program, 1);
+
+    planner.setZoneFlowRates({ 10, 5 });
+    EXPECT_TRUE(planner.isPlanned(0));
+}
+
+TEST_F(ZoneProgramPlannerTest, never_opens_a_zone_twice) {
+    ZoneProgramPlanner planner;
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }) } },
+        ZoneProgram { base, { step(0, minutes { 10 }) } },
+    });
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 2);
+    EXPECT_EQ(runs[1].start, base + minutes { 10 });
+}
+
+TEST_F(ZoneProgramPlannerTest, fits_steps_into_windows) {
+    ZoneProgramPlanner planner;
+    planner.setWindows({
+        { base + hours { 1 }, base + hours { 1 } + minutes { 15 } },
+        { base + hours { 2 }, base + hours { 3 } },
+    });
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }), step(1, minutes { 10 }) } },
+    });
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 2);
+    EXPECT_EQ(runs[0].start, base + hours { 1 });
+    EXPECT_EQ(runs[1].start, base + hours { 2 });
+}
+
+TEST_F(ZoneProgramPlannerTest, rejects_program_that_does_not_fit) {
+    ZoneProgramPlanner planner;
+    planner.setWindows({
+        { base, base + minutes { 15 } },
+    });
+    planner.setPrograms({
+        ZoneProgram { base, { step(0, minutes { 10 }), step(1, minutes { 10 }) } },
+        ZoneProgram { base, { step(2, minutes { 5 }) } },
+    });
+    EXPECT_FALSE(planner.isPlanned(0));
+    EXPECT_TRUE(planner.isPlanned(1));
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 1);
+    EXPECT_EQ(runs[0].zone, 2);
+    EXPECT_EQ(runs[0].start, base);
+}
+
+TEST_F(ZoneProgramPlannerTest, replans_only_changed_programs) {
+    ZoneProgramPlanner planner(1, 0);
+    std::vector<ZoneProgram> programs {
+        ZoneProgram { base, { step(0, minutes { 10 }) } },
+        ZoneProgram { base, { step(1, minutes { 10 }) } },
+        ZoneProgram { base, { step(2, minutes { 10 }) } },
+    };
+    planner.setPrograms(programs);
+    EXPECT_EQ(planner.getLastReplanned(), 3);
+
+    planner.setPrograms(programs);
+    EXPECT_EQ(planner.getLastReplanned(), 0);
+
+    programs[1].steps[0].duration = minutes { 20 };
+    planner.setPrograms(programs);
+    EXPECT_EQ(planner.getLastReplanned(), 2);
+    auto& runs = planner.getRuns();
+    ASSERT_EQ(runs.size(), 3);
+    EXPECT_EQ(runs[0].start, base);
+    EXPECT_EQ(runs[1].start, base + minutes { 10 });
+    EXPECT_EQ(runs[2].start, base + minutes { 30 });
+
+    programs.pop_back();
+    planner.setPrograms(programs);
+    EXPECT_EQ(planner.getRuns().size(), 2);
+    EXPECT_FALSE(planner.isZoneActive(2, base + minutes { 30 }));
+}
+
+TEST_F(ZoneProgramPlannerTest, incremental_plan_matches_full_plan) {
+    std::vector<ZoneProgram> programs;
+    for (int i = 0; i < 20; i++) {
+        programs.push_back(ZoneProgram { base + minutes { i * 7 }, { step(i % 4, minutes { 5 + i % 3 }), step((i + 1) % 4, minutes { 3 }) } });
+    }
+    ZoneProgramPlanner incremental(2, 0);
+    incremental.setPrograms(programs);
+    programs[10].steps[0].duration = minutes { 12 };
+    programs[15].start += minutes { 1 };
+    incremental.setPrograms(programs);
+
+    ZoneProgramPlanner full(2, 0);
+    full.setPrograms(programs);
+
+    auto& incrementalRuns = incremental.getRuns();
+    auto& fullRuns = full.getRuns();
+    ASSERT_EQ(incrementalRuns.size(), fullRuns.size());
+    for (size_t i = 0; i < fullRuns.size(); i++) {
+        EXPECT_EQ(incrementalRuns[i].zone, fullRuns[i].zone);
+        EXPECT_EQ(incrementalRuns[i].start, fullRuns[i].start);
+        EXPECT_EQ(incrementalRuns[i].end, fullRuns[i].end);
+    }
+}
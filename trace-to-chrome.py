@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""
+Converts a trace dumped by the device to Chrome trace JSON, to be opened in Perfetto (https://ui.perfetto.dev).
+
+Reads either a serial log containing the lines printed by the "trace" command with "serial": true,
+or the JSON responses of the "trace" command, one per line. Other lines are ignored.
+
+Usage: trace-to-chrome.py [input] > trace.json
+"""
+
+import fileinput
+import json
+
+
+def parse_line(line):
+    line = line.strip()
+    if line.startswith("trace "):
+        _, phase, timestamp, thread, name = line.split(" ", 4)
+        return [(int(timestamp), phase, int(thread, 16), name)]
+    if line.startswith("{"):
+        try:
+            response = json.loads(line)
+        except ValueError:
+            return []
+        return [(int(timestamp), phase, int(thread), name) for timestamp, phase, thread, name in response.get("events", [])]
+    return []
+
+
+def main():
+    events = []
+    for line in fileinput.input():
+        events.extend(parse_line(line))
+    # Pages may overlap, and the ring may have been dumped more than once
+    events = sorted(set(events))
+
+    threads = {}
+    trace_events = []
+    for timestamp, phase, thread, name in events:
+        tid = threads.setdefault(thread, len(threads))
+        event = {"name": name, "ph": phase, "ts": timestamp, "pid": 0, "tid": tid}
+        if phase == "i":
+            event["s"] = "t"
+        trace_events.append(event)
+    for thread, tid in threads.items():
+        trace_events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": tid, "args": {"name": "%08x" % thread}})
+
+    print(json.dumps({"traceEvents": trace_events, "displayTimeUnit": "ms"}))
+
+
+if __name__ == "__main__":
+    main()